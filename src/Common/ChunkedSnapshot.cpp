@@ -0,0 +1,678 @@
+//=================================================================================================
+//  ChunkedSnapshot.cpp
+//  Contains functions for writing and reading snapshot files in the chunked binary format,
+//  including the (byte-shuffle + LZ) compression codec used for individual chunks.
+//
+//  This file is part of GANDALF :
+//  Graphical Astrophysics code for N-body Dynamics And Lagrangian Fluids
+//  https://github.com/gandalfcode/gandalf
+//  Contact : gandalfcode@gmail.com
+//
+//  Copyright (C) 2013  D. A. Hubber, G. Rosotti
+//
+//  GANDALF is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  GANDALF is distributed in the hope that it will be useful, but
+//  WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  General Public License (http://www.gnu.org/licenses) for more details.
+//=================================================================================================
+
+
+#include <algorithm>
+#include <cassert>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include "ChunkedSnapshot.h"
+#include "BinaryIO.h"
+#include "Debug.h"
+#include "Exception.h"
+using namespace std;
+
+
+static const int lz_hashbits  = 12;    // No. of bits of hash table for finding matches
+static const int lz_minmatch  = 4;     // Minimum length of a match
+static const int lz_maxoffset = 65535; // Maximum distance of a match (2-byte offset)
+static const int lz_lastbytes = 5;     // Bytes at the end of a block always stored as literals
+
+
+
+//=================================================================================================
+//  ShuffleBytes
+/// Reorder bytes so that the i-th bytes of all elements are stored together.  Neighbouring
+/// particles have similar values, so the exponent (and leading mantissa) bytes become long runs
+/// of similar bytes, which compress much better.  Trailing bytes are copied unchanged.
+//=================================================================================================
+static void ShuffleBytes
+ (const char *in,                      ///< [in] Input data
+  int nbytes,                          ///< [in] Size of data
+  int elsize,                          ///< [in] Size of each element
+  char *out)                           ///< [out] Shuffled data
+{
+  const int Nel = nbytes/elsize;
+  for (int b=0; b<elsize; b++) {
+    for (int i=0; i<Nel; i++) out[b*Nel + i] = in[i*elsize + b];
+  }
+  for (int i=Nel*elsize; i<nbytes; i++) out[i] = in[i];
+  return;
+}
+
+
+
+//=================================================================================================
+//  UnshuffleBytes
+/// Inverse of ShuffleBytes.
+//=================================================================================================
+static void UnshuffleBytes
+ (const char *in,                      ///< [in] Shuffled data
+  int nbytes,                          ///< [in] Size of data
+  int elsize,                          ///< [in] Size of each element
+  char *out)                           ///< [out] Original data
+{
+  const int Nel = nbytes/elsize;
+  for (int b=0; b<elsize; b++) {
+    for (int i=0; i<Nel; i++) out[i*elsize + b] = in[b*Nel + i];
+  }
+  for (int i=Nel*elsize; i<nbytes; i++) out[i] = in[i];
+  return;
+}
+
+
+
+//=================================================================================================
+//  WriteLength
+/// Write the remainder of a literal or match length that does not fit in the token nibble.
+/// Returns false if there is no space left in the output buffer.
+//=================================================================================================
+static inline bool WriteLength
+ (int len,                             ///< [in] Remaining length (i.e. minus 15)
+  unsigned char *&op,                  ///< [inout] Output pointer
+  const unsigned char *oend)           ///< [in] End of output buffer
+{
+  while (len >= 255) {
+    if (op >= oend) return false;
+    *op++ = 255;
+    len -= 255;
+  }
+  if (op >= oend) return false;
+  *op++ = (unsigned char) len;
+  return true;
+}
+
+
+
+//=================================================================================================
+//  WriteSequence
+/// Write one LZ sequence, i.e. a token, the literal bytes and (if matchlen > 0) the offset and
+/// length of the match.  Returns false if there is no space left in the output buffer.
+//=================================================================================================
+static bool WriteSequence
+ (const unsigned char *literals,       ///< [in] Start of literal bytes
+  int Nliteral,                        ///< [in] No. of literal bytes
+  int offset,                          ///< [in] Distance of match
+  int matchlen,                        ///< [in] Length of match (or 0 for last sequence)
+  unsigned char *&op,                  ///< [inout] Output pointer
+  const unsigned char *oend)           ///< [in] End of output buffer
+{
+  const int mcode = (matchlen > 0) ? matchlen - lz_minmatch : 0;
+
+  if (op >= oend) return false;
+  *op++ = (unsigned char) ((min(Nliteral, 15) << 4) | min(mcode, 15));
+  if (Nliteral >= 15 && !WriteLength(Nliteral - 15, op, oend)) return false;
+  if (op + Nliteral > oend) return false;
+  memcpy(op, literals, Nliteral);
+  op += Nliteral;
+
+  if (matchlen > 0) {
+    if (op + 2 > oend) return false;
+    *op++ = (unsigned char) (offset & 255);
+    *op++ = (unsigned char) (offset >> 8);
+    if (mcode >= 15 && !WriteLength(mcode - 15, op, oend)) return false;
+  }
+
+  return true;
+}
+
+
+
+//=================================================================================================
+//  LZCompress
+/// Compress a block with a simple LZ77 scheme (similar to the LZ4 block format).  Matches are
+/// found with a single-entry hash table of the previous position of each 4-byte sequence.
+/// Returns the size of the compressed data, or -1 if it does not fit in 'maxbytes'.
+//=================================================================================================
+static int LZCompress
+ (const unsigned char *in,             ///< [in] Input data
+  int nbytes,                          ///< [in] Size of input data
+  unsigned char *out,                  ///< [out] Compressed data
+  int maxbytes)                        ///< [in] Size of output buffer
+{
+  int table[1 << lz_hashbits];         // Last position of each hashed 4-byte sequence
+  int anchor = 0;                      // Start of pending literals
+  int i = 0;                           // Current position
+  unsigned char *op = out;             // Output pointer
+  const unsigned char *oend = out + maxbytes;
+
+  for (int k=0; k<(1 << lz_hashbits); k++) table[k] = -1;
+
+  while (i + lz_minmatch <= nbytes - lz_lastbytes) {
+    unsigned int seq;
+    memcpy(&seq, in + i, sizeof(seq));
+    const int hash = (int) ((seq*2654435761U) >> (32 - lz_hashbits));
+    const int cand = table[hash];
+    table[hash] = i;
+
+    if (cand >= 0 && i - cand <= lz_maxoffset && memcmp(in + cand, in + i, lz_minmatch) == 0) {
+      int matchlen = lz_minmatch;
+      while (i + matchlen < nbytes - lz_lastbytes && in[cand + matchlen] == in[i + matchlen]) {
+        matchlen++;
+      }
+      if (!WriteSequence(in + anchor, i - anchor, i - cand, matchlen, op, oend)) return -1;
+      i += matchlen;
+      anchor = i;
+    }
+    else {
+      i++;
+    }
+  }
+
+  // Last sequence only contains literals
+  if (!WriteSequence(in + anchor, nbytes - anchor, 0, 0, op, oend)) return -1;
+
+  return (int) (op - out);
+}
+
+
+
+//=================================================================================================
+//  LZDecompress
+/// Decompress a block compressed with LZCompress.  All lengths and offsets are checked, so a
+/// corrupted block cannot read or write outside the buffers.  Returns false if the block is
+/// corrupted or does not decompress to exactly 'nbytes' bytes.
+//=================================================================================================
+static bool LZDecompress
+ (const unsigned char *in,             ///< [in] Compressed data
+  int ninbytes,                        ///< [in] Size of compressed data
+  unsigned char *out,                  ///< [out] Decompressed data
+  int nbytes)                          ///< [in] Expected size of decompressed data
+{
+  const unsigned char *ip = in;
+  const unsigned char *iend = in + ninbytes;
+  unsigned char *op = out;
+  unsigned char *oend = out + nbytes;
+
+  while (ip < iend) {
+    const int token = *ip++;
+
+    // Literals
+    int Nliteral = token >> 4;
+    if (Nliteral == 15) {
+      int len;
+      do {
+        if (ip >= iend) return false;
+        len = *ip++;
+        Nliteral += len;
+      } while (len == 255);
+    }
+    if (Nliteral > iend - ip || Nliteral > oend - op) return false;
+    memcpy(op, ip, Nliteral);
+    ip += Nliteral;
+    op += Nliteral;
+    if (ip == iend) break;
+
+    // Match (copied byte by byte since the source and destination may overlap)
+    if (iend - ip < 2) return false;
+    const int offset = ip[0] | (ip[1] << 8);
+    ip += 2;
+    int matchlen = (token & 15) + lz_minmatch;
+    if ((token & 15) == 15) {
+      int len;
+      do {
+        if (ip >= iend) return false;
+        len = *ip++;
+        matchlen += len;
+      } while (len == 255);
+    }
+    if (offset == 0 || offset > op - out || matchlen > oend - op) return false;
+    const unsigned char *match = op - offset;
+    for (int k=0; k<matchlen; k++) op[k] = match[k];
+    op += matchlen;
+  }
+
+  return (op == oend);
+}
+
+
+
+//=================================================================================================
+//  ChunkedCompress
+/// Compress one chunk with the given codec.  Returns the size of the compressed chunk, or -1 if
+/// the compressed chunk would not be smaller than the raw data (in which case the chunk should
+/// be stored uncompressed).  The output buffer must be at least 2*nbytes long.
+//=================================================================================================
+int ChunkedCompress
+ (const char *in,                      ///< [in] Raw chunk data
+  int nbytes,                          ///< [in] Size of raw chunk data
+  int elsize,                          ///< [in] Size of each element
+  int codec,                           ///< [in] Codec (codec_none or codec_shuffle_lz)
+  char *out)                           ///< [out] Compressed data
+{
+  if (codec != codec_shuffle_lz || nbytes == 0) return -1;
+
+  // Shuffle into the second half of the output buffer, then compress into the first half
+  char *shuffled = out + nbytes;
+  ShuffleBytes(in, nbytes, elsize, shuffled);
+  int ncompressed = LZCompress(reinterpret_cast<const unsigned char *>(shuffled), nbytes,
+                               reinterpret_cast<unsigned char *>(out), nbytes - 1);
+
+  return ncompressed;
+}
+
+
+
+//=================================================================================================
+//  ChunkedDecompress
+/// Decompress one chunk that was compressed with ChunkedCompress.  Returns false if the chunk
+/// is corrupted.
+//=================================================================================================
+bool ChunkedDecompress
+ (const char *in,                      ///< [in] Compressed chunk data
+  int ninbytes,                        ///< [in] Size of compressed chunk data
+  int elsize,                          ///< [in] Size of each element
+  int codec,                           ///< [in] Codec used for compressing chunk
+  char *out,                           ///< [out] Raw chunk data
+  int nbytes)                          ///< [in] Size of raw chunk data
+{
+  if (codec == codec_none) {
+    if (ninbytes != nbytes) return false;
+    memcpy(out, in, nbytes);
+    return true;
+  }
+  else if (codec == codec_shuffle_lz) {
+    vector<char> shuffled(nbytes);
+    if (!LZDecompress(reinterpret_cast<const unsigned char *>(in), ninbytes,
+                      reinterpret_cast<unsigned char *>(&shuffled[0]), nbytes)) return false;
+    UnshuffleBytes(&shuffled[0], nbytes, elsize, out);
+    return true;
+  }
+
+  return false;
+}
+
+
+
+//=================================================================================================
+//  ChunkedSnapshotWriter::ChunkedSnapshotWriter
+/// Open file and write a placeholder header (completed by Close once the index is written).
+//=================================================================================================
+ChunkedSnapshotWriter::ChunkedSnapshotWriter
+ (string filename,                     ///< [in] Name of snapshot file
+  int _ndim,                           ///< [in] No. of dimensions
+  int _Nchunk,                         ///< [in] No. of particles per chunk
+  int _codec):                         ///< [in] Codec used for compressing chunks
+  codec(_codec),
+  ndim(_ndim),
+  Nchunk(max(_Nchunk, 1))
+{
+  for (int i=0; i<chunked_nheader; i++) idata[i] = 0;
+  for (int i=0; i<chunked_nheader; i++) ilpdata[i] = 0;
+  for (int i=0; i<chunked_nheader; i++) ddata[i] = 0.0;
+
+  const int Nheaderbytes = chunked_string_length + 2*sizeof(int) + chunked_nheader*sizeof(int) +
+    chunked_nheader*sizeof(long) + chunked_nheader*sizeof(DOUBLE) + sizeof(long);
+  vector<char> header(Nheaderbytes, 0);
+  outfile.open(filename.c_str(), ios::binary);
+  outfile.write(&header[0], Nheaderbytes);
+}
+
+
+
+//=================================================================================================
+//  ChunkedSnapshotWriter::WriteChunks
+/// Divide the given array into chunks of Nchunk elements, compress them and write them to file,
+/// recording the position, size and codec of each chunk in the field index.
+//=================================================================================================
+void ChunkedSnapshotWriter::WriteChunks
+ (ChunkedSnapshotField &field,         ///< [inout] Index entry of field
+  const char *data,                    ///< [in] Raw data of field
+  int N,                               ///< [in] No. of elements
+  int elsize)                          ///< [in] Size of each element
+{
+  buffer.resize(2*Nchunk*elsize);
+
+  // Align the start of each field, so uncompressed fields can be used directly from a
+  // memory-mapped file
+  const int Npad = (chunked_alignment - (int) (outfile.tellp() % chunked_alignment)) %
+    chunked_alignment;
+  if (Npad > 0) {
+    vector<char> padding(Npad, 0);
+    outfile.write(&padding[0], Npad);
+  }
+
+  for (int i=0; i<N; i+=Nchunk) {
+    const int nbytes = min(Nchunk, N - i)*elsize;
+    const char *chunk = data + i*elsize;
+    int ncompressed = ChunkedCompress(chunk, nbytes, elsize, codec, &buffer[0]);
+
+    field.offset.push_back((long) outfile.tellp());
+    if (ncompressed > 0) {
+      outfile.write(&buffer[0], ncompressed);
+      field.nbytes.push_back(ncompressed);
+      field.codec.push_back(codec);
+    }
+    else {
+      outfile.write(chunk, nbytes);
+      field.nbytes.push_back(nbytes);
+      field.codec.push_back(codec_none);
+    }
+  }
+
+  return;
+}
+
+
+
+//=================================================================================================
+//  ChunkedSnapshotWriter::WriteField
+/// Write a floating point field.  If 'bbdim' is given, the field is the bbdim-th position
+/// coordinate and is also used to compute the bounding boxes of all chunks of the species.
+//=================================================================================================
+void ChunkedSnapshotWriter::WriteField
+ (string name,                         ///< [in] Name of field
+  string unit,                         ///< [in] Name of (output) unit of field
+  int species,                         ///< [in] Particle species
+  const FLOAT *values,                 ///< [in] Field values of all particles
+  int N,                               ///< [in] No. of particles
+  int bbdim)                           ///< [in] Position coordinate of field (or -1)
+{
+  ChunkedSnapshotField field;
+  field.name     = name;
+  field.unit     = unit;
+  field.species  = species;
+  field.datatype = chunked_float;
+
+  debug2("[ChunkedSnapshotWriter::WriteField]");
+
+  // Record the range of this coordinate within each chunk
+  if (bbdim >= 0 && bbdim < ndim) {
+    const int Nchunks = (N + Nchunk - 1)/Nchunk;
+    bbox[species].resize(2*ndim*Nchunks);
+    for (int ichunk=0; ichunk<Nchunks; ichunk++) {
+      const int iend = min(N, (ichunk + 1)*Nchunk);
+      DOUBLE bbmin = values[ichunk*Nchunk];
+      DOUBLE bbmax = values[ichunk*Nchunk];
+      for (int i=ichunk*Nchunk; i<iend; i++) {
+        bbmin = min(bbmin, (DOUBLE) values[i]);
+        bbmax = max(bbmax, (DOUBLE) values[i]);
+      }
+      bbox[species][2*ndim*ichunk + bbdim]        = bbmin;
+      bbox[species][2*ndim*ichunk + ndim + bbdim] = bbmax;
+    }
+  }
+
+  WriteChunks(field, reinterpret_cast<const char *>(values), N, sizeof(FLOAT));
+  fields.push_back(field);
+
+  return;
+}
+
+
+
+//=================================================================================================
+//  ChunkedSnapshotWriter::WriteField
+/// Write an integer field.
+//=================================================================================================
+void ChunkedSnapshotWriter::WriteField
+ (string name,                         ///< [in] Name of field
+  string unit,                         ///< [in] Name of (output) unit of field
+  int species,                         ///< [in] Particle species
+  const int *values,                   ///< [in] Field values of all particles
+  int N)                               ///< [in] No. of particles
+{
+  ChunkedSnapshotField field;
+  field.name     = name;
+  field.unit     = unit;
+  field.species  = species;
+  field.datatype = chunked_int;
+
+  debug2("[ChunkedSnapshotWriter::WriteField]");
+
+  WriteChunks(field, reinterpret_cast<const char *>(values), N, sizeof(int));
+  fields.push_back(field);
+
+  return;
+}
+
+
+
+//=================================================================================================
+//  ChunkedSnapshotWriter::Close
+/// Write the index of all fields and chunks plus the chunk bounding boxes at the end of the
+/// file, then write the completed header at the start of the file and close it.
+//=================================================================================================
+bool ChunkedSnapshotWriter::Close(void)
+{
+  BinaryWriter writer(outfile);
+
+  debug2("[ChunkedSnapshotWriter::Close]");
+
+  idata[2] = Nchunk;
+  idata[3] = (int) fields.size();
+  idata[4] = codec;
+
+  // Write index
+  const long indexoffset = (long) outfile.tellp();
+  for (unsigned int j=0; j<fields.size(); j++) {
+    std::ostringstream stream;
+    stream << std::left << std::setw(chunked_string_length) << std::setfill(' ')
+           << fields[j].name.substr(0, chunked_string_length)
+           << std::setw(chunked_string_length) << std::setfill(' ')
+           << fields[j].unit.substr(0, chunked_string_length);
+    outfile << stream.str();
+    writer.write_value(fields[j].species);
+    writer.write_value(fields[j].datatype);
+    writer.write_value((int) fields[j].offset.size());
+    for (unsigned int ichunk=0; ichunk<fields[j].offset.size(); ichunk++) {
+      writer.write_value(fields[j].offset[ichunk]);
+      writer.write_value(fields[j].nbytes[ichunk]);
+      writer.write_value(fields[j].codec[ichunk]);
+    }
+  }
+  for (int s=0; s<chunked_Nspecies; s++) {
+    writer.write_value((int) bbox[s].size());
+    for (unsigned int i=0; i<bbox[s].size(); i++) writer.write_value(bbox[s][i]);
+  }
+
+  // Write header
+  outfile.seekp(0);
+  std::ostringstream stream;
+  stream << std::left << std::setw(chunked_string_length) << std::setfill(' ') << chunked_tag;
+  outfile << stream.str();
+  writer.write_value((int) sizeof(FLOAT));
+  writer.write_value(ndim);
+  for (int i=0; i<chunked_nheader; i++) writer.write_value(idata[i]);
+  for (int i=0; i<chunked_nheader; i++) writer.write_value(ilpdata[i]);
+  for (int i=0; i<chunked_nheader; i++) writer.write_value(ddata[i]);
+  writer.write_value(indexoffset);
+
+  outfile.close();
+
+  return !outfile.fail();
+}
+
+
+
+//=================================================================================================
+//  ChunkedSnapshotReader::Open
+/// Open snapshot file and read the header, the index of all fields and the chunk bounding boxes.
+/// Returns false if the file cannot be read or is not a chunked snapshot file.
+//=================================================================================================
+bool ChunkedSnapshotReader::Open
+ (string filename)                     ///< [in] Name of snapshot file
+{
+  long indexoffset;                    // Position of index in file
+  char tag[chunked_string_length];     // Format tag
+  BinaryReader reader(infile);
+
+  debug2("[ChunkedSnapshotReader::Open]");
+
+  infile.open(filename.c_str(), ios::binary);
+  if (!infile.good()) return false;
+
+  infile.read(tag, chunked_string_length);
+  string tagstring(tag, chunked_string_length);
+  tagstring = tagstring.substr(0, tagstring.find_last_not_of(' ') + 1);
+  if (tagstring != chunked_tag) {
+    ExceptionHandler::getIstance().raise("Incorrect format of chunked snapshot file " + filename);
+  }
+
+  reader.read_value(precision);
+  reader.read_value(ndim);
+  for (int i=0; i<chunked_nheader; i++) reader.read_value(idata[i]);
+  for (int i=0; i<chunked_nheader; i++) reader.read_value(ilpdata[i]);
+  for (int i=0; i<chunked_nheader; i++) reader.read_value(ddata[i]);
+  reader.read_value(indexoffset);
+  if (precision != sizeof(float) && precision != sizeof(double)) {
+    ExceptionHandler::getIstance().raise("Incorrect precision of chunked snapshot file " +
+                                         filename);
+  }
+
+  // Read index
+  infile.seekg(indexoffset);
+  fields.resize(idata[3]);
+  for (int j=0; j<idata[3]; j++) {
+    char buffer[chunked_string_length];
+    int Nchunks;
+    infile.read(buffer, chunked_string_length);
+    fields[j].name = string(buffer, chunked_string_length);
+    fields[j].name = fields[j].name.substr(0, fields[j].name.find_last_not_of(' ') + 1);
+    infile.read(buffer, chunked_string_length);
+    fields[j].unit = string(buffer, chunked_string_length);
+    fields[j].unit = fields[j].unit.substr(0, fields[j].unit.find_last_not_of(' ') + 1);
+    reader.read_value(fields[j].species);
+    reader.read_value(fields[j].datatype);
+    reader.read_value(Nchunks);
+    fields[j].offset.resize(Nchunks);
+    fields[j].nbytes.resize(Nchunks);
+    fields[j].codec.resize(Nchunks);
+    for (int ichunk=0; ichunk<Nchunks; ichunk++) {
+      reader.read_value(fields[j].offset[ichunk]);
+      reader.read_value(fields[j].nbytes[ichunk]);
+      reader.read_value(fields[j].codec[ichunk]);
+    }
+  }
+  for (int s=0; s<chunked_Nspecies; s++) {
+    int Nbbox;
+    reader.read_value(Nbbox);
+    bbox[s].resize(Nbbox);
+    for (int i=0; i<Nbbox; i++) reader.read_value(bbox[s][i]);
+  }
+
+  if (!infile.good()) {
+    ExceptionHandler::getIstance().raise("Could not read index of chunked snapshot file " +
+                                         filename);
+  }
+
+  return true;
+}
+
+
+
+//=================================================================================================
+//  ChunkedSnapshotReader::FindField
+/// Returns the index of the field with the given name and species, or -1 if not in the file.
+//=================================================================================================
+int ChunkedSnapshotReader::FindField
+ (string name,                         ///< [in] Name of field
+  int species) const                   ///< [in] Particle species
+{
+  for (unsigned int j=0; j<fields.size(); j++) {
+    if (fields[j].name == name && fields[j].species == species) return j;
+  }
+  return -1;
+}
+
+
+
+//=================================================================================================
+//  ChunkedSnapshotReader::Nchunks
+/// Returns the number of chunks of each field of the given species.
+//=================================================================================================
+int ChunkedSnapshotReader::Nchunks
+ (int species) const                   ///< [in] Particle species
+{
+  const int N = (species == chunked_hydro) ? idata[0] : idata[1];
+  return (N + idata[2] - 1)/idata[2];
+}
+
+
+
+//=================================================================================================
+//  ChunkedSnapshotReader::ChunkLength
+/// Returns the number of particles in the given chunk.
+//=================================================================================================
+int ChunkedSnapshotReader::ChunkLength
+ (int species,                         ///< [in] Particle species
+  int ichunk) const                    ///< [in] Chunk number
+{
+  const int N = (species == chunked_hydro) ? idata[0] : idata[1];
+  return min(idata[2], N - ichunk*idata[2]);
+}
+
+
+
+//=================================================================================================
+//  ChunkedSnapshotReader::ChunkOverlapsBox
+/// Returns true if the bounding box of the given chunk overlaps the box [boxmin, boxmax].
+/// Chunks without a recorded bounding box are always assumed to overlap.
+//=================================================================================================
+bool ChunkedSnapshotReader::ChunkOverlapsBox
+ (int species,                         ///< [in] Particle species
+  int ichunk,                          ///< [in] Chunk number
+  const DOUBLE *boxmin,                ///< [in] Minimum extent of box
+  const DOUBLE *boxmax) const          ///< [in] Maximum extent of box
+{
+  if ((int) bbox[species].size() < 2*ndim*(ichunk + 1)) return true;
+  const DOUBLE *bb = &bbox[species][2*ndim*ichunk];
+  for (int k=0; k<ndim; k++) {
+    if (bb[k] > boxmax[k] || bb[ndim + k] < boxmin[k]) return false;
+  }
+  return true;
+}
+
+
+
+//=================================================================================================
+//  ChunkedSnapshotReader::ReadChunk
+/// Read one chunk of a field from file and decompress it into 'data'.
+//=================================================================================================
+void ChunkedSnapshotReader::ReadChunk
+ (int ifield,                          ///< [in] Index of field
+  int ichunk,                          ///< [in] Chunk number
+  vector<char> &data)                  ///< [out] Raw (decompressed) chunk data
+{
+  const ChunkedSnapshotField &field = fields[ifield];
+  const int elsize = (field.datatype == chunked_int) ? (int) sizeof(int) : precision;
+  const int nbytes = ChunkLength(field.species, ichunk)*elsize;
+
+  assert(ichunk >= 0 && ichunk < (int) field.offset.size());
+
+  buffer.resize(max(field.nbytes[ichunk], 1));
+  data.resize(max(nbytes, 1));
+  infile.seekg(field.offset[ichunk]);
+  infile.read(&buffer[0], field.nbytes[ichunk]);
+
+  if (!infile.good() || !ChunkedDecompress(&buffer[0], field.nbytes[ichunk], elsize,
+                                           field.codec[ichunk], &data[0], nbytes)) {
+    ExceptionHandler::getIstance().raise("Corrupted chunk in chunked snapshot file (field " +
+                                         field.name + ")");
+  }
+
+  return;
+}
@@ -52,7 +52,8 @@ Ewald<ndim>::Ewald(DomainBox<ndim> &simbox, int _gr_bhewaldseriesn, int _in, int
   ly_per(simbox.size[1]),
   lz_per(simbox.size[2]),
   timing(_timing),
-  nEwaldGrid(_nEwaldGrid)
+  nEwaldGrid(_nEwaldGrid),
+  pm(NULL)
 {
   // Only create object (and run) for 3 dimensions.  Otherwise, throw an exception
   //-----------------------------------------------------------------------------------------------
@@ -481,6 +482,38 @@ Ewald<ndim>::Ewald(DomainBox<ndim> &simbox, int _gr_bhewaldseriesn, int _in, int
 
 
 
+//=================================================================================================
+//  Ewald::Ewald
+/// Constructor for periodic gravity object using the TreePM method.  No Ewald table is created;
+/// instead the periodic correction of the tree is replaced by the short-range truncation of the
+/// given particle-mesh object (which also computes the long-range forces).
+//=================================================================================================
+template <int ndim>
+Ewald<ndim>::Ewald(DomainBox<ndim> &simbox, ParticleMesh<ndim> *_pm, CodeTiming* _timing):
+  ewald_periodicity(7),
+  one_component(0),
+  ewald_field(NULL),
+  ewald_fields(NULL),
+  ewald_fieldl(NULL),
+  accPlane(0.0),
+  potC1p2i(0.0),
+  gr_bhewaldseriesn(0),
+  in(0),
+  ewald_mult(0.0),
+  ixmin(0.0),
+  ixmax(0.0),
+  EFratio(0.0),
+  lx_per(simbox.size[0]),
+  ly_per(simbox.size[1]),
+  lz_per(ndim == 3 ? simbox.size[2] : 0.0),
+  nEwaldGrid(0),
+  pm(_pm),
+  timing(_timing)
+{
+}
+
+
+
 //=================================================================================================
 //  Ewald::~Ewald
 /// Ewald object destructor.  Deallocates all memory for look-up tables
@@ -488,6 +521,7 @@ Ewald<ndim>::Ewald(DomainBox<ndim> &simbox, int _gr_bhewaldseriesn, int _in, int
 template <int ndim>
 Ewald<ndim>::~Ewald()
 {
+  if (pm != NULL) delete pm;
 }
 
 
@@ -503,6 +537,13 @@ void Ewald<ndim>::CalculatePeriodicCorrection
   FLOAT acorr[ndim],                   ///< [out] Periodic correction acceleration
   FLOAT &gpotcorr)                     ///< [out] Periodic correction grav. potential
 {
+  // For TreePM, the periodic (long-range) contribution comes from the mesh, so only replace the
+  // Newtonian interaction computed by the tree with the short-range force
+  if (pm != NULL) {
+    pm->CalculateShortRangeCorrection(m, dr, acorr, gpotcorr);
+    return;
+  }
+
   // Only compile for 3 dimensions
   //-----------------------------------------------------------------------------------------------
   if (ndim == 3) {
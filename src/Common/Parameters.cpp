@@ -185,6 +185,11 @@ void Parameters::SetDefaultValues(void)
   intparams["litesnap"] = 0;
   floatparams["dt_litesnap"] = 0.2;
   floatparams["tlitesnapfirst"] = 0.0;
+  intparams["async_output"] = 0;
+  intparams["Noutputqueue"] = 2;
+  intparams["snap_chunk_size"] = 16384;
+  stringparams["snap_compression"] = "shuffle_lz";
+  intparams["snap_mmap"] = 1;
 
   // Unit and scaling parameters
   //-----------------------------------------------------------------------------------------------
@@ -254,6 +259,7 @@ void Parameters::SetDefaultValues(void)
   intparams["tabulated_kernel"] = 1;
   floatparams["h_fac"] = 1.2;
   floatparams["h_converge"] = 0.01;
+  intparams["symmetric_hydro_forces"] = 0;
 
   // Thermal physics parameters
   //-----------------------------------------------------------------------------------------------
@@ -310,6 +316,11 @@ void Parameters::SetDefaultValues(void)
   intparams["Nleafmax"] = 6;
   intparams["ntreebuildstep"] = 1;
   intparams["ntreestockstep"] = 1;
+  intparams["nreorderstep"] = 0;
+  stringparams["sfc_curve"] = "hilbert";
+  floatparams["neib_skin"] = 0.0;
+  intparams["tree_refit"] = 0;
+  floatparams["tree_refit_tol"] = 0.25;
   floatparams["thetamaxsqd"] = 0.1;
   floatparams["macerror"] = 0.0001;
 
@@ -395,6 +406,14 @@ void Parameters::SetDefaultValues(void)
   floatparams["ixmax"] = 5.0;
   floatparams["EFratio"] = 1.0;
 
+  // TreePM periodic gravity parameters
+  //-----------------------------------------------------------------------------------------------
+  stringparams["periodic_gravity"] = "ewald";
+  intparams["pm_grid"] = 64;
+  stringparams["pm_assignment"] = "tsc";
+  floatparams["pm_asmth"] = 1.25;
+  floatparams["pm_rcut"] = 4.5;
+
   // Initial conditions parameters
   //-----------------------------------------------------------------------------------------------
   stringparams["particle_distribution"] = "cubic_lattice";
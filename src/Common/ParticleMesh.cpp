@@ -0,0 +1,505 @@
+//=================================================================================================
+//  ParticleMesh.cpp
+//  Class functions for computing the long-range part of periodic gravity on a mesh with FFTs
+//  for the TreePM method.
+//
+//  This file is part of GANDALF :
+//  Graphical Astrophysics code for N-body Dynamics And Lagrangian Fluids
+//  https://github.com/gandalfcode/gandalf
+//  Contact : gandalfcode@gmail.com
+//
+//  Copyright (C) 2013  D. A. Hubber, G. Rosotti
+//
+//  GANDALF is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  GANDALF is distributed in the hope that it will be useful, but
+//  WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  General Public License (http://www.gnu.org/licenses) for more details.
+//=================================================================================================
+
+
+#include <algorithm>
+#include <cmath>
+#include <math.h>
+#include <string>
+#include "Exception.h"
+#include "ParticleMesh.h"
+#include "Hydrodynamics.h"
+#include "Nbody.h"
+#include "Debug.h"
+#include "InlineFuncs.h"
+using namespace std;
+
+
+
+//=================================================================================================
+//  ParticleMesh::ParticleMesh
+/// Constructor for particle-mesh long-range gravity object.  Sets the force-split scale to
+/// asmth mesh cells and the short-range cut-off radius to rcutfactor force-split scales.
+//=================================================================================================
+template <int ndim>
+ParticleMesh<ndim>::ParticleMesh
+ (const DomainBox<ndim> &_simbox,      ///< [in] Simulation domain box
+  int _Ngrid,                          ///< [in] No. of mesh cells per dimension
+  string assignment,                   ///< [in] Mass assignment scheme (cic or tsc)
+  FLOAT asmth,                         ///< [in] Force-split scale in units of mesh cells
+  FLOAT rcutfactor,                    ///< [in] Cut-off radius in units of force-split scale
+  CodeTiming *_timing):                ///< [in] Pointer to code timing object
+  simbox(_simbox),
+  Ngrid(_Ngrid),
+  timing(_timing)
+{
+  DOUBLE dxmax = 0.0;                  // Largest mesh cell size
+  FLOAT halfmin = big_number;          // Smallest half side-length of box
+
+  debug2("[ParticleMesh::ParticleMesh]");
+
+  if (assignment == "cic") order = 2;
+  else if (assignment == "tsc") order = 3;
+  else {
+    string message = "Unrecognised parameter : pm_assignment = " + assignment;
+    ExceptionHandler::getIstance().raise(message);
+  }
+
+  for (int k=0; k<ndim; k++) {
+    if (simbox.boundary_lhs[k] != periodicBoundary || simbox.boundary_rhs[k] != periodicBoundary) {
+      ExceptionHandler::getIstance().raise("Error: TreePM gravity requires periodic boundaries "
+                                           "in all dimensions");
+    }
+  }
+
+#if !defined(FFTW_TURBULENCE)
+  if (Ngrid < 2 || (Ngrid & (Ngrid - 1)) != 0) {
+    ExceptionHandler::getIstance().raise("Error: pm_grid must be a power of two when not "
+                                         "compiled with FFTW");
+  }
+#endif
+
+  Nmesh = 1;
+  for (int k=0; k<ndim; k++) {
+    Nmesh *= Ngrid;
+    dxmesh[k] = (DOUBLE) simbox.size[k]/(DOUBLE) Ngrid;
+    dxmax = max(dxmax, dxmesh[k]);
+    halfmin = min(halfmin, simbox.half[k]);
+  }
+  rsplit = asmth*dxmax;
+  rcut   = rcutfactor*rsplit;
+
+  // The tree only uses the nearest periodic replica, so the short-range force must vanish
+  // within half the box
+  if (rcut > halfmin) {
+    ExceptionHandler::getIstance().raise("Error: TreePM cut-off radius larger than half the "
+                                         "box size; increase pm_grid or decrease pm_rcut");
+  }
+
+  rho.resize(Nmesh);
+  meshpot.resize(Nmesh);
+  for (int k=0; k<ndim; k++) meshacc[k].resize(Nmesh);
+  phik.resize(Nmesh);
+  work.resize(Nmesh);
+
+#if defined(FFTW_TURBULENCE)
+  int n[ndim];
+  for (int k=0; k<ndim; k++) n[k] = Ngrid;
+  fftw_complex *w = reinterpret_cast<fftw_complex *>(&work[0]);
+  forward_plan  = fftw_plan_dft(ndim, n, w, w, FFTW_FORWARD, FFTW_ESTIMATE);
+  backward_plan = fftw_plan_dft(ndim, n, w, w, FFTW_BACKWARD, FFTW_ESTIMATE);
+#endif
+}
+
+
+
+//=================================================================================================
+//  ParticleMesh::~ParticleMesh
+/// Destructor for particle-mesh long-range gravity object.
+//=================================================================================================
+template <int ndim>
+ParticleMesh<ndim>::~ParticleMesh()
+{
+#if defined(FFTW_TURBULENCE)
+  fftw_destroy_plan(forward_plan);
+  fftw_destroy_plan(backward_plan);
+#endif
+}
+
+
+
+//=================================================================================================
+//  ParticleMesh::ComputeStencil
+/// Compute the mesh cell indices and weights of the assignment scheme for position rp in each
+/// dimension.  Entries for dimension k are stored at index 3*k onwards.  Returns the no. of
+/// mesh cells per dimension in the stencil.
+//=================================================================================================
+template <int ndim>
+int ParticleMesh<ndim>::ComputeStencil
+ (const FLOAT *rp,                     ///< [in] Position
+  int *index,                          ///< [out] Mesh cell indices (3 per dimension)
+  DOUBLE *weight) const                ///< [out] Weights (3 per dimension)
+{
+  for (int k=0; k<ndim; k++) {
+    const DOUBLE u = ((DOUBLE) rp[k] - (DOUBLE) simbox.min[k])/dxmesh[k];
+
+    if (order == 2) {
+      const int i0 = (int) floor(u);
+      const DOUBLE f = u - (DOUBLE) i0;
+      index[3*k]      = i0;
+      index[3*k + 1]  = i0 + 1;
+      weight[3*k]     = 1.0 - f;
+      weight[3*k + 1] = f;
+    }
+    else {
+      const int i0 = (int) floor(u + 0.5);
+      const DOUBLE d = u - (DOUBLE) i0;
+      index[3*k]      = i0 - 1;
+      index[3*k + 1]  = i0;
+      index[3*k + 2]  = i0 + 1;
+      weight[3*k]     = 0.5*(0.5 - d)*(0.5 - d);
+      weight[3*k + 1] = 0.75 - d*d;
+      weight[3*k + 2] = 0.5*(0.5 + d)*(0.5 + d);
+    }
+
+    // Wrap indices periodically
+    for (int j=0; j<order; j++) {
+      index[3*k + j] %= Ngrid;
+      if (index[3*k + j] < 0) index[3*k + j] += Ngrid;
+    }
+  }
+
+  return order;
+}
+
+
+
+//=================================================================================================
+//  ParticleMesh::AssignMass
+/// Assign the mass of a particle at position rp to the mesh density.
+//=================================================================================================
+template <int ndim>
+void ParticleMesh<ndim>::AssignMass
+ (const FLOAT *rp,                     ///< [in] Position of particle
+  const FLOAT m)                       ///< [in] Mass of particle
+{
+  int index[3*ndim];                   // Mesh cell indices of stencil
+  DOUBLE weight[3*ndim];               // Weights of stencil
+  DOUBLE cellvol = 1.0;                // Volume of mesh cell
+
+  const int n = ComputeStencil(rp, index, weight);
+  int Npoints = 1;
+  for (int k=0; k<ndim; k++) Npoints *= n;
+  for (int k=0; k<ndim; k++) cellvol *= dxmesh[k];
+
+  for (int p=0; p<Npoints; p++) {
+    int c = p;
+    int imesh = 0;
+    int stride = 1;
+    DOUBLE w = (DOUBLE) m/cellvol;
+    for (int k=0; k<ndim; k++) {
+      const int j = c % n;
+      c /= n;
+      imesh  += index[3*k + j]*stride;
+      stride *= Ngrid;
+      w      *= weight[3*k + j];
+    }
+    rho[imesh] += w;
+  }
+
+  return;
+}
+
+
+
+//=================================================================================================
+//  ParticleMesh::ComputeMeshField
+/// Compute the long-range potential and acceleration on the mesh due to all hydro particles
+/// which contribute to gravity and all N-body particles.
+//=================================================================================================
+template <int ndim>
+void ParticleMesh<ndim>::ComputeMeshField
+ (Hydrodynamics<ndim> *hydro,          ///< [in] Pointer to hydrodynamics object
+  Nbody<ndim> *nbody)                  ///< [in] Pointer to N-body object
+{
+  debug2("[ParticleMesh::ComputeMeshField]");
+  CodeTiming::BlockTimer timer = timing->StartNewTimer("PM_GRAVITY");
+
+  // Assign mass of all particles to mesh
+  for (int i=0; i<Nmesh; i++) rho[i] = 0.0;
+  for (int j=0; j<hydro->Nhydro; j++) {
+    Particle<ndim> &part = hydro->GetParticlePointer(j);
+    if (part.flags.is_dead() || !hydro->types.gravmask[part.ptype]) continue;
+    AssignMass(part.r, part.m);
+  }
+  for (int j=0; j<nbody->Nnbody; j++) {
+    AssignMass(nbody->nbodydata[j]->r, nbody->nbodydata[j]->m);
+  }
+
+  SolveMeshField();
+
+  return;
+}
+
+
+
+//=================================================================================================
+//  ParticleMesh::SolveMeshField
+/// Solve for the long-range potential and acceleration on the mesh from the mesh density.  The
+/// density is Fourier transformed, multiplied by the Green's function of the long-range
+/// potential, 4 pi exp(-k^2 rs^2)/k^2, (deconvolved by the assignment window twice, for
+/// assignment and interpolation) and the potential and accelerations (i k phi_k) are
+/// transformed back to the mesh.  The k = 0 mode is the limit of the difference between the
+/// long-range and Newtonian Green's functions, -4 pi rs^2, so the total (mesh plus short-range)
+/// potential has zero mean, as for the Ewald sum with a neutralising background.
+//=================================================================================================
+template <int ndim>
+void ParticleMesh<ndim>::SolveMeshField(void)
+{
+  int i;                               // Mesh cell counter
+  vector<DOUBLE> kgrid[ndim];          // Wavenumbers of mesh modes in each dimension
+  vector<DOUBLE> window(Ngrid);        // Assignment window of mesh modes
+
+  // Wavenumbers and assignment window for all modes
+  for (int k=0; k<ndim; k++) kgrid[k].resize(Ngrid);
+  for (int n=0; n<Ngrid; n++) {
+    const int m = (n < Ngrid/2) ? n : n - Ngrid;
+    const DOUBLE x = pi_dp*(DOUBLE) m/(DOUBLE) Ngrid;
+    const DOUBLE sinc = (m == 0) ? 1.0 : sin(x)/x;
+    window[n] = pow(sinc, order);
+    for (int k=0; k<ndim; k++) kgrid[k][n] = twopi_dp*(DOUBLE) m/(DOUBLE) simbox.size[k];
+  }
+
+  // Forward transform of density and multiplication with Green's function
+  for (i=0; i<Nmesh; i++) work[i] = complex<DOUBLE>(rho[i], 0.0);
+  TransformMesh(-1);
+
+  for (i=0; i<Nmesh; i++) {
+    int c = i;
+    DOUBLE ksqd = 0.0;
+    DOUBLE w = 1.0;
+    for (int k=0; k<ndim; k++) {
+      const int n = c % Ngrid;
+      c /= Ngrid;
+      ksqd += kgrid[k][n]*kgrid[k][n];
+      w    *= window[n];
+    }
+    if (i == 0) phik[i] = -work[i]*(4.0*pi_dp*rsplit*rsplit);
+    else phik[i] = work[i]*(4.0*pi_dp*exp(-ksqd*rsplit*rsplit)/(ksqd*w*w));
+  }
+
+  // Transform potential back to mesh
+  for (i=0; i<Nmesh; i++) work[i] = phik[i];
+  TransformMesh(1);
+  for (i=0; i<Nmesh; i++) meshpot[i] = work[i].real()/(DOUBLE) Nmesh;
+
+  // Transform accelerations (i.e. i*k*phi_k) back to mesh.  The Nyquist modes have no
+  // well-defined derivative and are dropped.
+  for (int k=0; k<ndim; k++) {
+    int stride = 1;
+    for (int kk=0; kk<k; kk++) stride *= Ngrid;
+    for (i=0; i<Nmesh; i++) {
+      const int n = (i/stride) % Ngrid;
+      if (n == Ngrid/2) work[i] = 0.0;
+      else work[i] = complex<DOUBLE>(0.0, kgrid[k][n])*phik[i];
+    }
+    TransformMesh(1);
+    for (i=0; i<Nmesh; i++) meshacc[k][i] = work[i].real()/(DOUBLE) Nmesh;
+  }
+
+  return;
+}
+
+
+
+//=================================================================================================
+//  ParticleMesh::InterpolateMeshForces
+/// Add the long-range acceleration and potential interpolated from the mesh to position rp.
+//=================================================================================================
+template <int ndim>
+void ParticleMesh<ndim>::InterpolateMeshForces
+ (const FLOAT *rp,                     ///< [in] Position
+  FLOAT *agrav,                        ///< [inout] Acceleration
+  FLOAT &gpot) const                   ///< [inout] Grav. potential
+{
+  int index[3*ndim];                   // Mesh cell indices of stencil
+  DOUBLE weight[3*ndim];               // Weights of stencil
+  DOUBLE a[ndim];                      // Interpolated acceleration
+  DOUBLE pot = 0.0;                    // Interpolated potential
+
+  const int n = ComputeStencil(rp, index, weight);
+  int Npoints = 1;
+  for (int k=0; k<ndim; k++) Npoints *= n;
+  for (int k=0; k<ndim; k++) a[k] = 0.0;
+
+  for (int p=0; p<Npoints; p++) {
+    int c = p;
+    int imesh = 0;
+    int stride = 1;
+    DOUBLE w = 1.0;
+    for (int k=0; k<ndim; k++) {
+      const int j = c % n;
+      c /= n;
+      imesh  += index[3*k + j]*stride;
+      stride *= Ngrid;
+      w      *= weight[3*k + j];
+    }
+    pot += w*meshpot[imesh];
+    for (int k=0; k<ndim; k++) a[k] += w*meshacc[k][imesh];
+  }
+
+  for (int k=0; k<ndim; k++) agrav[k] += (FLOAT) a[k];
+  gpot += (FLOAT) pot;
+
+  return;
+}
+
+
+
+//=================================================================================================
+//  ParticleMesh::CalculateShortRangeCorrection
+/// Correction to the Newtonian (tree) force between a particle and a particle/cell of mass m
+/// at the relative position dr, so that only the short-range force is computed by the tree,
+/// i.e. subtracts the long-range part computed by the mesh.  If dr is not the nearest
+/// periodic replica, the Newtonian force is also moved to the nearest replica.
+//=================================================================================================
+template <int ndim>
+void ParticleMesh<ndim>::CalculateShortRangeCorrection
+ (FLOAT m,                             ///< [in] Mass of particle/cell
+  FLOAT dr[ndim],                      ///< [in] Relative vector to particle/cell
+  FLOAT acorr[ndim],                   ///< [out] Correction acceleration
+  FLOAT &gpotcorr) const               ///< [out] Correction grav. potential
+{
+  int k;                               // Dimension counter
+  bool nearest = true;                 // Is dr the nearest periodic replica?
+  FLOAT drmag;                         // Distance
+  FLOAT invdrmag;                      // 1 / distance
+  FLOAT u;                             // Distance in units of 2*rsplit
+  FLOAT along;                         // Long-range acceleration factor
+  FLOAT potlong;                       // Long-range potential
+  const FLOAT inv2rs = (FLOAT) 0.5/rsplit;
+  const FLOAT twoinvsqrtpi = (FLOAT) 1.12837916709551;
+
+  for (k=0; k<ndim; k++) acorr[k] = (FLOAT) 0.0;
+  gpotcorr = (FLOAT) 0.0;
+
+  for (k=0; k<ndim; k++) {
+    if (fabs(dr[k]) > simbox.half[k]) nearest = false;
+  }
+  if (!nearest) {
+    invdrmag = (FLOAT) 1.0/sqrt(DotProduct(dr, dr, ndim) + small_number);
+    for (k=0; k<ndim; k++) acorr[k] -= m*dr[k]*invdrmag*invdrmag*invdrmag;
+    gpotcorr -= m*invdrmag;
+    for (k=0; k<ndim; k++) {
+      if (dr[k] > simbox.half[k]) dr[k] -= simbox.size[k];
+      else if (dr[k] < -simbox.half[k]) dr[k] += simbox.size[k];
+    }
+    invdrmag = (FLOAT) 1.0/sqrt(DotProduct(dr, dr, ndim) + small_number);
+    for (k=0; k<ndim; k++) acorr[k] += m*dr[k]*invdrmag*invdrmag*invdrmag;
+    gpotcorr += m*invdrmag;
+  }
+
+  // Long-range force and potential, m*erf(u)/r, using series expansions at small separations
+  drmag = sqrt(DotProduct(dr, dr, ndim));
+  u = drmag*inv2rs;
+  if (u < (FLOAT) 0.01) {
+    along   = m*inv2rs*inv2rs*inv2rs*(FLOAT) 2.0*twoinvsqrtpi*onethird*((FLOAT) 1.0 - (FLOAT) 0.6*u*u);
+    potlong = m*inv2rs*twoinvsqrtpi*((FLOAT) 1.0 - onethird*u*u);
+  }
+  else {
+    invdrmag = (FLOAT) 1.0/drmag;
+    along    = m*invdrmag*invdrmag*invdrmag*(erf(u) - twoinvsqrtpi*u*exp(-u*u));
+    potlong  = m*erf(u)*invdrmag;
+  }
+
+  for (k=0; k<ndim; k++) acorr[k] -= along*dr[k];
+  gpotcorr -= potlong;
+
+  return;
+}
+
+
+
+//=================================================================================================
+//  ParticleMesh::TransformMesh
+/// In-place FFT of the work array, with sign = -1 for the forward and +1 for the (unnormalised)
+/// backward transform.  Uses FFTW if available, otherwise transforms all lines of the mesh
+/// along each dimension in turn with the internal radix-2 FFT.
+//=================================================================================================
+template <int ndim>
+void ParticleMesh<ndim>::TransformMesh
+ (const int sign)                      ///< [in] Sign of exponent of transform
+{
+#if defined(FFTW_TURBULENCE)
+  if (sign < 0) fftw_execute(forward_plan);
+  else fftw_execute(backward_plan);
+#else
+  const int Nlines = Nmesh/Ngrid;
+  int stride = 1;
+
+  for (int k=0; k<ndim; k++) {
+
+#pragma omp parallel default(none) shared(stride,Nlines,sign)
+    {
+      vector<complex<DOUBLE> > line(Ngrid);
+
+#pragma omp for
+      for (int l=0; l<Nlines; l++) {
+        const int start = (l/stride)*stride*Ngrid + l % stride;
+        for (int n=0; n<Ngrid; n++) line[n] = work[start + n*stride];
+        TransformLine(&line[0], Ngrid, sign);
+        for (int n=0; n<Ngrid; n++) work[start + n*stride] = line[n];
+      }
+    }
+
+    stride *= Ngrid;
+  }
+#endif
+
+  return;
+}
+
+
+
+//=================================================================================================
+//  ParticleMesh::TransformLine
+/// Iterative in-place radix-2 complex FFT of a single line of length n (a power of two).
+//=================================================================================================
+template <int ndim>
+void ParticleMesh<ndim>::TransformLine
+ (complex<DOUBLE> *a,                  ///< [inout] Data to be transformed
+  const int n,                         ///< [in] Length of data
+  const int sign)                      ///< [in] Sign of exponent of transform
+{
+  // Bit-reversal permutation
+  for (int i=1, j=0; i<n; i++) {
+    int bit = n >> 1;
+    for (; j & bit; bit >>= 1) j ^= bit;
+    j ^= bit;
+    if (i < j) swap(a[i], a[j]);
+  }
+
+  // Butterflies
+  for (int len=2; len<=n; len<<=1) {
+    const DOUBLE theta = (DOUBLE) sign*twopi_dp/(DOUBLE) len;
+    const complex<DOUBLE> wlen(cos(theta), sin(theta));
+    for (int i=0; i<n; i+=len) {
+      complex<DOUBLE> w(1.0, 0.0);
+      for (int j=0; j<len/2; j++) {
+        const complex<DOUBLE> u = a[i + j];
+        const complex<DOUBLE> v = a[i + j + len/2]*w;
+        a[i + j]         = u + v;
+        a[i + j + len/2] = u - v;
+        w *= wlen;
+      }
+    }
+  }
+
+  return;
+}
+
+
+
+template class ParticleMesh<1>;
+template class ParticleMesh<2>;
+template class ParticleMesh<3>;
@@ -190,6 +190,7 @@ SimulationBase::SimulationBase
 
 
   paramfile             = "";
+  async_output          = 0;
   integration_step      = 1;
   litesnap              = 0;
   n                     = 0;
@@ -201,6 +202,7 @@ SimulationBase::SimulationBase
   Nmpi                  = 1;
   Noutsnap              = 0;
   Noutlitesnap          = 0;
+  Noutputqueue          = 2;
   Nsteps                = 0;
   rank                  = 0;
   dt_snap_wall          = 0.0;
@@ -239,6 +241,7 @@ SimulationBase::SimulationBase
 //=================================================================================================
 SimulationBase::~SimulationBase()
 {
+  FlushSnapshotWriters();
   if (timing != NULL)
     delete timing ;
 }
@@ -411,6 +414,9 @@ void SimulationBase::Run
   }
   //-----------------------------------------------------------------------------------------------
 
+  // Wait for all snapshots still being written in the background
+  FlushSnapshotWriters();
+
   FinaliseSimulation();
   CalculateDiagnostics();
   OutputDiagnostics();
@@ -484,6 +490,7 @@ list<SphSnapshotBase*> SimulationBase::InteractiveRun
 
   // Calculate and process all diagnostic quantities
   if (t >= tend || Nsteps >= Ntarget) {
+    FlushSnapshotWriters();
     FinaliseSimulation();
     CalculateDiagnostics();
     OutputDiagnostics();
@@ -506,7 +513,6 @@ string SimulationBase::Output(void)
   string nostring;                  // String of number of snapshots
   string fileend;                   // Name of restart file
   stringstream ss;                  // Stream object for preparing filename
-  ofstream outfile;                 // Stream of restart file
 
   debug2("[SimulationBase::Output]");
   CodeTiming::BlockTimer timer = timing->StartNewTimer("OUTPUT");
@@ -535,7 +541,7 @@ string SimulationBase::Output(void)
     nostring = ss.str();
     filename = run_id + ".slite." + nostring;
     ss.str(std::string());
-    WriteSnapshotFile(filename,"slite");
+    OutputSnapshotFile(filename,"slite");
 
   }
   //-----------------------------------------------------------------------------------------------
@@ -553,17 +559,13 @@ string SimulationBase::Output(void)
     nostring = ss.str();
     filename = run_id + '.' + out_file_form + '.' + nostring;
     ss.str(std::string());
-    WriteSnapshotFile(filename,out_file_form);
 
-    // Now write name and format of snapshot to file (for restarts)
-    if (rank == 0) {
+    // Write snapshot, and then the name and format of snapshot to file (for restarts)
+    fileend = "restart";
+    filename2 = run_id + "." + fileend;
+    OutputSnapshotFile(filename, out_file_form, (rank == 0) ? filename2 : "");
 
-      fileend = "restart";
-      filename2 = run_id + "." + fileend;
-      outfile.open(filename2.c_str());
-      outfile << out_file_form << endl;
-      outfile << filename << endl;
-      outfile.close();
+    if (rank == 0) {
 
       // Finally, calculate wall-clock time interval since last output snapshot
       if (tsnap_wallclock > 0.0) dt_snap_wall = timing->RunningTime() - tsnap_wallclock;
@@ -611,21 +613,16 @@ void SimulationBase::RestartSnapshot(void)
   string filename;                     // Temporary output snapshot filename
   string filename2;                    // Restart log filename
   stringstream ss;                     // Stream object for preparing filename
-  ofstream outfile;                    // Stream of restart file
 
   debug2("[SimulationBase::RestartSnapshot]");
 
   // Prepare filename for new snapshot
   filename = run_id + "." + out_file_form + ".tmp";
   ss.str(std::string());
-  WriteSnapshotFile(filename,out_file_form);
 
-  // Now write name and format of snapshot to file (for restarts)
+  // Write snapshot, and then the name and format of snapshot to file (for restarts)
   filename2 = run_id + ".restart";
-  outfile.open(filename2.c_str());
-  outfile << out_file_form << endl;
-  outfile << filename << endl;
-  outfile.close();
+  OutputSnapshotFile(filename, out_file_form, filename2);
 
   return;
 }
@@ -1191,17 +1188,46 @@ void Simulation<ndim>::ProcessParameters(void)
       ExceptionHandler::getIstance().raise("Error: Periodic/Ewald gravity only supported in 3D");
     }
     ewaldGravity = true;
-    ewald = new Ewald<ndim>
-      (simbox, intparams["gr_bhewaldseriesn"], intparams["in"], intparams["nEwaldGrid"],
-       floatparams["ewald_mult"], floatparams["ixmin"], floatparams["ixmax"],
-       floatparams["EFratio"], timing);
+    if (stringparams["periodic_gravity"] == "ewald") {
+      ewald = new Ewald<ndim>
+        (simbox, intparams["gr_bhewaldseriesn"], intparams["in"], intparams["nEwaldGrid"],
+         floatparams["ewald_mult"], floatparams["ixmin"], floatparams["ixmax"],
+         floatparams["EFratio"], timing);
+    }
+    else if (stringparams["periodic_gravity"] == "treepm") {
+#ifdef MPI_PARALLEL
+      ExceptionHandler::getIstance().raise("Error: periodic_gravity = treepm is not supported "
+                                           "with MPI");
+#endif
+      ParticleMesh<ndim> *pm = new ParticleMesh<ndim>
+        (simbox, intparams["pm_grid"], stringparams["pm_assignment"],
+         floatparams["pm_asmth"], floatparams["pm_rcut"], timing);
+      ewald = new Ewald<ndim>(simbox, pm, timing);
+    }
+    else {
+      string message = "Unrecognised parameter : periodic_gravity = "
+        + simparams->stringparams["periodic_gravity"];
+      ExceptionHandler::getIstance().raise(message);
+    }
     simbox.PeriodicGravity = true ;
   }
   else {
     simbox.PeriodicGravity = false ;
   }
 
+  // The dual-tree walk (fmm) has no periodic (Ewald) or MPI (pruned-tree) gravity corrections
+  if (stringparams["multipole"] == "fmm" && simbox.PeriodicGravity) {
+    ExceptionHandler::getIstance().raise("Error: multipole = fmm is not supported with "
+                                         "periodic gravity");
+  }
+#ifdef MPI_PARALLEL
+  if (stringparams["multipole"] == "fmm") {
+    ExceptionHandler::getIstance().raise("Error: multipole = fmm is not supported with MPI");
+  }
+#endif
+
   // Set other important simulation variables
+  async_output        = intparams["async_output"];
   dt_litesnap         = floatparams["dt_litesnap"]/simunits.t.outscale;
   dt_python           = floatparams["dt_python"];
   dt_snap             = floatparams["dt_snap"]/simunits.t.outscale;
@@ -1211,6 +1237,7 @@ void Simulation<ndim>::ProcessParameters(void)
   Nlevels             = intparams["Nlevels"];
   ndiagstep           = intparams["ndiagstep"];
   noutputstep         = intparams["noutputstep"];
+  Noutputqueue        = intparams["Noutputqueue"];
   nrestartstep        = intparams["nrestartstep"];
   ntreebuildstep      = intparams["ntreebuildstep"];
   ntreestockstep      = intparams["ntreestockstep"];
@@ -1226,6 +1253,11 @@ void Simulation<ndim>::ProcessParameters(void)
   tlitesnapnext       = floatparams["tlitesnapfirst"]/simunits.t.outscale;
   tsnapnext           = floatparams["tsnapfirst"]/simunits.t.outscale;
 
+  // Snapshots are written collectively by all MPI processes, so are always written directly
+#ifdef MPI_PARALLEL
+  async_output        = 0;
+#endif
+
 }
 
 //=================================================================================================
@@ -1765,6 +1797,7 @@ void Simulation<ndim>::ComputeBlockTimesteps(void)
 {
   int i;                                     // Particle counter
   int istep;                                 // Aux. variable for changing steps
+  int j;                                     // Aux. particle counter
   int last_level;                            // Previous timestep level
   int level;                                 // Particle timestep level
   int level_max_aux;                         // Aux. maximum level variable
@@ -1774,6 +1807,7 @@ void Simulation<ndim>::ComputeBlockTimesteps(void)
   int level_min_hydro = 9999999;               // level_min for hydro particles
   int level_nbody;                           // local thread var. for N-body level
   int level_hydro;                             // local thread var. for hydro level
+  int Nendstep = 0;                          // No. of hydro particles on synchronised levels
   int nfactor;                               // Increase/decrease factor of n
   int nstep;                                 // Particle integer step-size
   DOUBLE dt;                                 // Aux. timestep variable
@@ -1922,6 +1956,13 @@ void Simulation<ndim>::ComputeBlockTimesteps(void)
     assert(nresync > 0);
     timestep = dt_max / (DOUBLE) nresync;
 
+    // Rebuild the per-level particle index (all particles start a new step here)
+    if (hydro != NULL) {
+      hydro->InvalidateLevelIndex();
+      hydro->FindEndOfStepParticles(n, level_step);
+      hydro->UpdateLevelIndex(n);
+    }
+
   }
   // If not resynchronising, check if any hydro/N-body particles need to move
   // up or down timestep levels.
@@ -1933,9 +1974,20 @@ void Simulation<ndim>::ComputeBlockTimesteps(void)
     level_max_nbody = 0;
     level_max_hydro = 0;
 
+    // Only hydro particles on the timestep levels synchronised at n can reach the end of their
+    // step, so only loop over these.  The remaining particles only contribute their (unchanged)
+    // maximum level and minimum timestep.
+    if (hydro != NULL) {
+      Nendstep        = hydro->FindEndOfStepParticles(n, level_step);
+      level_max_hydro = hydro->MaxInactiveLevel(dt);
+      level_max       = level_max_hydro;
+      dt_min          = min(dt_min, dt);
+      dt_min_hydro    = min(dt_min_hydro, dt);
+    }
+
 
 #pragma omp parallel default(shared) private(dt,dt_nbody,dt_hydro,i)\
-     private(istep,last_level,level,level_max_aux,level_nbody,level_hydro,nstep,nfactor)
+     private(istep,j,last_level,level,level_max_aux,level_nbody,level_hydro,nstep,nfactor)
     {
       dt_hydro      = big_number_dp;
       dt_nbody      = big_number_dp;
@@ -1948,9 +2000,9 @@ void Simulation<ndim>::ComputeBlockTimesteps(void)
       //-------------------------------------------------------------------------------------------
       if (hydro != NULL) {
 #pragma omp for
-        for (i=0; i<hydro->Nhydro; i++) {
+        for (j=0; j<Nendstep; j++) {
+          i = hydro->endsteplist[j];
           Particle<ndim>& part = hydro->GetParticlePointer(i);
-          if (part.flags.is_dead()) continue;
 
           // hydro particles whose timestep has been artificially reduced by Saitoh & Makino scheme.
           if (n - part.nlast == part.nstep && part.nstep != pow(2,level_step - part.level)) {
@@ -2088,9 +2140,8 @@ void Simulation<ndim>::ComputeBlockTimesteps(void)
     if (hydro != NULL) {
       // Set fixed hydro timestep level here in case maximum has changed
       if (hydro_single_timestep == 1) {
-        for (i=0; i<hydro->Nhydro; i++) {
-          Particle<ndim>& part = hydro->GetParticlePointer(i);
-          if (part.flags.is_dead()) continue;
+        for (j=0; j<Nendstep; j++) {
+          Particle<ndim>& part = hydro->GetParticlePointer(hydro->endsteplist[j]);
           if (part.nlast == n) part.level = level_max_hydro;
         }
       }
@@ -2137,11 +2188,13 @@ void Simulation<ndim>::ComputeBlockTimesteps(void)
 
     // Update values of nstep for both hydro and star particles
     if (hydro != NULL) {
-      for (i=0; i<hydro->Nhydro; i++) {
-        Particle<ndim>& part = hydro->GetParticlePointer(i);
-        if (part.flags.is_dead()) continue;
+      for (j=0; j<Nendstep; j++) {
+        Particle<ndim>& part = hydro->GetParticlePointer(hydro->endsteplist[j]);
         if (part.nlast == n) part.nstep = pow(2, level_step - part.level);
       }
+
+      // Move the particles that started a new step to the buckets of their new levels
+      hydro->UpdateLevelIndex(n);
     }
     if (nbody != NULL) {
       for (i=0; i<nbody->Nnbody; i++) {
@@ -27,12 +27,16 @@
 #include <string>
 #include <cstdio>
 #include <cstring>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
 #include "Simulation.h"
 #include "Parameters.h"
 #include "Debug.h"
 #include "HeaderInfo.h"
 #include "formatted_output.h"
 #include "BinaryIO.h"
+#include "ChunkedSnapshot.h"
 #ifdef MPI_PARALLEL
 #include <mpi.h>
 #endif
@@ -77,6 +81,9 @@ bool SimulationBase::ReadSnapshotFile
   else if (fileform == "su" || fileform == "seren_unform") {
     return ReadSerenUnformSnapshotFile(filename);
   }
+  else if (fileform == "chunked" || fileform == "gandalf_chunked") {
+    return ReadChunkedSnapshotFile(filename);
+  }
   else {
     cout << "Unrecognised file format" << endl;
     return false;
@@ -111,6 +118,9 @@ bool SimulationBase::WriteSnapshotFile
   else if (fileform == "slite" || fileform == "seren_lite") {
     return WriteSerenLiteSnapshotFile(filename);
   }
+  else if (fileform == "chunked" || fileform == "gandalf_chunked") {
+    return WriteChunkedSnapshotFile(filename);
+  }
   else {
     cout << "Unrecognised file format" << endl;
     return false;
@@ -119,6 +129,143 @@ bool SimulationBase::WriteSnapshotFile
 
 
 
+//=================================================================================================
+//  SimulationBase::OutputSnapshotFile
+/// Write snapshot file with specified filename and format, and then (if given) record it in the
+/// restart log file.  If asynchronous output is selected, the snapshot is written by a forked
+/// background process that shares a copy-on-write image of the particle data, so the simulation
+/// can continue while the snapshot is formatted and written.  At most 'Noutputqueue' snapshots
+/// are written in the background at once, and the restart log is only updated by the main
+/// process once the snapshot has been completely written (in the order the snapshots were
+/// queued).  Falls back to writing the snapshot directly if no process can be created.
+//=================================================================================================
+bool SimulationBase::OutputSnapshotFile
+ (string filename,                     ///< [in] Name of output snapshot file
+  string fileform,                     ///< [in] Format of output snapshot file
+  string restartlog)                   ///< [in] Name of restart log file ("" = none)
+{
+  debug2("[Simulation::OutputSnapshotFile]");
+
+#if !defined(MPI_PARALLEL)
+  if (async_output) {
+    bool pending = true;                 // Is the same file still being written?
+    list<SnapshotWriter>::iterator it;   // Iterator over queued writers
+
+    // Collect any finished writers, and block until no other writer is still writing to the
+    // same file (e.g. the temporary restart snapshot) and there is a free slot in the queue
+    while (WaitForSnapshotWriter(false));
+    while (pending) {
+      pending = false;
+      for (it = snapwriters.begin(); it != snapwriters.end(); ++it) {
+        if (it->filename == filename) pending = true;
+      }
+      if (pending) WaitForSnapshotWriter(true);
+    }
+    while ((int) snapwriters.size() >= max(Noutputqueue, 1)) WaitForSnapshotWriter(true);
+
+    // Flush all output streams so buffered output is not duplicated by the child process
+    cout.flush();
+    fflush(NULL);
+
+    pid_t pid = fork();
+
+    // Background process : write the snapshot and exit without any clean-up of the simulation
+    if (pid == 0) {
+      bool okflag = WriteSnapshotFile(filename, fileform);
+      cout.flush();
+      fflush(NULL);
+      _exit(okflag ? 0 : 1);
+    }
+    else if (pid > 0) {
+      SnapshotWriter writer;
+      writer.pid        = (int) pid;
+      writer.filename   = filename;
+      writer.fileform   = fileform;
+      writer.restartlog = restartlog;
+      snapwriters.push_back(writer);
+      return true;
+    }
+
+    cout << "Warning: could not create background process for writing snapshot; "
+         << "writing snapshot directly" << endl;
+  }
+#endif
+
+  // Otherwise write the snapshot directly
+  bool okflag = WriteSnapshotFile(filename, fileform);
+  if (okflag && restartlog != "") WriteRestartLog(restartlog, fileform, filename);
+
+  return okflag;
+}
+
+
+
+//=================================================================================================
+//  SimulationBase::WaitForSnapshotWriter
+/// Check if the oldest background snapshot writer has finished (or wait until it has if 'block'
+/// is set) and, if it completed successfully, update the restart log.  Returns true if a writer
+/// was removed from the queue.
+//=================================================================================================
+bool SimulationBase::WaitForSnapshotWriter
+ (bool block)                          ///< [in] Wait for the writer to finish?
+{
+  int status;                          // Exit status of background process
+
+  if (snapwriters.empty()) return false;
+
+  SnapshotWriter &writer = snapwriters.front();
+  pid_t pid = waitpid((pid_t) writer.pid, &status, block ? 0 : WNOHANG);
+  if (pid == 0) return false;
+
+  if (pid < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    cout << "Warning: background writer failed for snapshot file : " << writer.filename << endl;
+  }
+  else if (writer.restartlog != "") {
+    WriteRestartLog(writer.restartlog, writer.fileform, writer.filename);
+  }
+  snapwriters.pop_front();
+
+  return true;
+}
+
+
+
+//=================================================================================================
+//  SimulationBase::FlushSnapshotWriters
+/// Wait until all queued background snapshot writers have finished.
+//=================================================================================================
+void SimulationBase::FlushSnapshotWriters(void)
+{
+  debug2("[Simulation::FlushSnapshotWriters]");
+
+  while (WaitForSnapshotWriter(true));
+
+  return;
+}
+
+
+
+//=================================================================================================
+//  SimulationBase::WriteRestartLog
+/// Write the name and format of the last complete snapshot to the restart log file.
+//=================================================================================================
+void SimulationBase::WriteRestartLog
+ (string restartlog,                   ///< [in] Name of restart log file
+  string fileform,                     ///< [in] Format of snapshot file
+  string filename)                     ///< [in] Name of snapshot file
+{
+  ofstream outfile;                    // Stream of restart log file
+
+  outfile.open(restartlog.c_str());
+  outfile << fileform << endl;
+  outfile << filename << endl;
+  outfile.close();
+
+  return;
+}
+
+
+
 //=================================================================================================
 //  SimulationBase::ReadHeaderSnapshotFile
 /// Read the header of a snapshot file, given the filename and the format.  Return information
@@ -144,6 +291,9 @@ HeaderInfo SimulationBase::ReadHeaderSnapshotFile
   else if (fileform == "su" || fileform == "seren_unform") {
     ReadSerenUnformHeaderFile(infile, info);
   }
+  else if (fileform == "chunked" || fileform == "gandalf_chunked") {
+    ReadChunkedHeaderFile(filename, info);
+  }
   else {
     ExceptionHandler::getIstance().raise("Unrecognised file format");
   }
@@ -1328,7 +1478,7 @@ bool Simulation<ndim>::ReadSerenUnformSnapshotFile(string filename)
 
   // Precision
   reader.read_value(dummy);
-#if defined GANDALF_DOUBLE_PRECISION
+#if defined GANDALF_DOUBLE_PRECISION || defined GANDALF_MIXED_PRECISION
   if (dummy != 8) {
 #else
   if (dummy !=4) {
@@ -1827,7 +1977,7 @@ bool Simulation<ndim>::WriteSerenUnformSnapshotFile(string filename)
                       << binary_tag;
     outfile << stream.str();
 
-#if defined GANDALF_DOUBLE_PRECISION
+#if defined GANDALF_DOUBLE_PRECISION || defined GANDALF_MIXED_PRECISION
     writer.write_value(8);
 #else
     writer.write_value(4);
@@ -2169,7 +2319,7 @@ bool Simulation<ndim>::WriteSerenUnformSnapshotFile(string filename)
   }
 
 
-#if defined GANDALF_DOUBLE_PRECISION
+#if defined GANDALF_DOUBLE_PRECISION || defined GANDALF_MIXED_PRECISION
   writer.write_value(8);
 #else
   writer.write_value(4);
@@ -2499,6 +2649,359 @@ bool Simulation<ndim>::WriteSerenLiteSnapshotFile(string filename)
 
 
 
+//=================================================================================================
+//  Simulation::ReadChunkedHeaderFile
+/// Function for reading the header of a chunked snapshot file.  Does not modify the variables
+/// of the Simulation class, but rather returns information in a HeaderInfo struct.
+//=================================================================================================
+template <int ndim>
+void Simulation<ndim>::ReadChunkedHeaderFile
+ (string filename,                     ///< [in] Name of snapshot file
+  HeaderInfo& info)                    ///< [out] Header data structure
+{
+  ChunkedSnapshotReader reader;        // Chunked snapshot file reader
+
+  debug2("[Simulation::ReadChunkedHeaderFile]");
+
+  if (!reader.Open(filename)) {
+    ExceptionHandler::getIstance().raise("Could not open snapshot file " + filename);
+  }
+
+  info.ndim   = reader.ndim;
+  info.Nhydro = reader.idata[0] - reader.idata[8];
+  info.Ndust  = reader.idata[8];
+  info.Nstar  = reader.idata[1];
+  info.t      = reader.ddata[0]/simunits.t.inscale;
+  reader.Close();
+
+  // Check dimensionality matches if using fixed dimensions
+  if (info.ndim != ndim) {
+    std::ostringstream stream;
+    stream << "Incorrect no. of dimensions in file : "
+           << info.ndim << "  [ndim : " << ndim << "]" << endl;
+    ExceptionHandler::getIstance().raise(stream.str());
+  }
+
+  return;
+}
+
+
+
+//=================================================================================================
+//  Simulation::ReadChunkedSnapshotFile
+/// Read all hydro and N-body particle data from a chunked snapshot file into main arrays.
+/// As with the other binary formats, all values are in output units and are converted to code
+/// units afterwards by ConvertToCodeUnits.
+//=================================================================================================
+template <int ndim>
+bool Simulation<ndim>::ReadChunkedSnapshotFile(string filename)
+{
+  int ifield;                          // Index of field in file
+  int k;                               // Dimension counter
+  ChunkedSnapshotReader reader;        // Chunked snapshot file reader
+  vector<FLOAT> values;                // Field values of one chunk
+  vector<int> ivalues;                 // Integer field values of one chunk
+  static const string rnames[3] = {"x", "y", "z"};
+  static const string vnames[3] = {"vx", "vy", "vz"};
+
+  debug2("[Simulation::ReadChunkedSnapshotFile]");
+
+  if (!reader.Open(filename)) {
+    ExceptionHandler::getIstance().raise("Could not open snapshot file " + filename);
+  }
+  if (reader.ndim != ndim) {
+    std::ostringstream stream;
+    stream << "Incorrect NDIM in file " << filename << " : got " << reader.ndim
+           << ", expected " << ndim << endl;
+    ExceptionHandler::getIstance().raise(stream.str());
+  }
+
+  hydro->Nhydro = reader.idata[0];
+  nbody->Nstar  = reader.idata[1];
+  sinks->Nsink  = reader.idata[1];
+  Nsteps        = reader.ilpdata[1];
+  t             = reader.ddata[0];
+
+  // Variables that should be remembered for restarts
+  if (restart) {
+    Noutsnap      = reader.ilpdata[0];
+    Nsteps        = reader.ilpdata[1];
+    Noutlitesnap  = reader.ilpdata[2];
+    t             = reader.ddata[0];
+    tsnaplast     = reader.ddata[1];
+    hydro->mmean  = reader.ddata[2];
+    tlitesnaplast = reader.ddata[3];
+  }
+
+  AllocateParticleMemory();
+  values.resize(reader.idata[2]);
+  ivalues.resize(reader.idata[2]);
+
+
+  // Hydro particles (all fields default to gas particles if not present in file)
+  //-----------------------------------------------------------------------------------------------
+  for (int i=0; i<hydro->Nhydro; i++) {
+    Particle<ndim>& part = hydro->GetParticlePointer(i);
+    part.ptype = gas_type;
+    part.flags = none;
+  }
+
+  for (int ichunk=0; ichunk<reader.Nchunks(chunked_hydro); ichunk++) {
+    const int i0 = ichunk*reader.idata[2];
+    const int N  = reader.ChunkLength(chunked_hydro, ichunk);
+
+    if ((ifield = reader.FindField("iorig", chunked_hydro)) != -1) {
+      reader.ReadFieldChunk(ifield, ichunk, &ivalues[0]);
+      for (int i=0; i<N; i++) hydro->GetParticlePointer(i0 + i).iorig = ivalues[i];
+    }
+    if ((ifield = reader.FindField("ptype", chunked_hydro)) != -1) {
+      reader.ReadFieldChunk(ifield, ichunk, &ivalues[0]);
+      for (int i=0; i<N; i++) hydro->GetParticlePointer(i0 + i).ptype = ivalues[i];
+    }
+    for (k=0; k<ndim; k++) {
+      if ((ifield = reader.FindField(rnames[k], chunked_hydro)) != -1) {
+        reader.ReadFieldChunk(ifield, ichunk, &values[0]);
+        for (int i=0; i<N; i++) hydro->GetParticlePointer(i0 + i).r[k] = values[i];
+      }
+      if ((ifield = reader.FindField(vnames[k], chunked_hydro)) != -1) {
+        reader.ReadFieldChunk(ifield, ichunk, &values[0]);
+        for (int i=0; i<N; i++) hydro->GetParticlePointer(i0 + i).v[k] = values[i];
+      }
+    }
+    if ((ifield = reader.FindField("m", chunked_hydro)) != -1) {
+      reader.ReadFieldChunk(ifield, ichunk, &values[0]);
+      for (int i=0; i<N; i++) hydro->GetParticlePointer(i0 + i).m = values[i];
+    }
+    if ((ifield = reader.FindField("h", chunked_hydro)) != -1) {
+      reader.ReadFieldChunk(ifield, ichunk, &values[0]);
+      for (int i=0; i<N; i++) hydro->GetParticlePointer(i0 + i).h = values[i];
+    }
+    if ((ifield = reader.FindField("rho", chunked_hydro)) != -1) {
+      reader.ReadFieldChunk(ifield, ichunk, &values[0]);
+      for (int i=0; i<N; i++) hydro->GetParticlePointer(i0 + i).rho = values[i];
+    }
+    if ((ifield = reader.FindField("u", chunked_hydro)) != -1) {
+      reader.ReadFieldChunk(ifield, ichunk, &values[0]);
+      for (int i=0; i<N; i++) hydro->GetParticlePointer(i0 + i).u = values[i];
+    }
+  }
+
+
+  // Sinks/stars
+  //-----------------------------------------------------------------------------------------------
+  for (int ichunk=0; ichunk<reader.Nchunks(chunked_star); ichunk++) {
+    const int i0 = ichunk*reader.idata[2];
+    const int N  = reader.ChunkLength(chunked_star, ichunk);
+
+    for (k=0; k<ndim; k++) {
+      if ((ifield = reader.FindField(rnames[k], chunked_star)) != -1) {
+        reader.ReadFieldChunk(ifield, ichunk, &values[0]);
+        for (int i=0; i<N; i++) nbody->stardata[i0 + i].r[k] = values[i];
+      }
+      if ((ifield = reader.FindField(vnames[k], chunked_star)) != -1) {
+        reader.ReadFieldChunk(ifield, ichunk, &values[0]);
+        for (int i=0; i<N; i++) nbody->stardata[i0 + i].v[k] = values[i];
+      }
+    }
+    if ((ifield = reader.FindField("m", chunked_star)) != -1) {
+      reader.ReadFieldChunk(ifield, ichunk, &values[0]);
+      for (int i=0; i<N; i++) nbody->stardata[i0 + i].m = values[i];
+    }
+    if ((ifield = reader.FindField("h", chunked_star)) != -1) {
+      reader.ReadFieldChunk(ifield, ichunk, &values[0]);
+      for (int i=0; i<N; i++) nbody->stardata[i0 + i].h = values[i];
+    }
+    if ((ifield = reader.FindField("radius", chunked_star)) != -1) {
+      reader.ReadFieldChunk(ifield, ichunk, &values[0]);
+      for (int i=0; i<N; i++) nbody->stardata[i0 + i].radius = values[i];
+    }
+  }
+
+  for (int i=0; i<nbody->Nstar; i++) {
+    sinks->sink[i].radius = nbody->stardata[i].radius;
+    sinks->sink[i].star = &(nbody->stardata[i]);
+    nbody->nbodydata[i] = &(nbody->stardata[i]);
+    assert(nbody->stardata[i].m > 0.0);
+  }
+
+  reader.Close();
+
+  return true;
+}
+
+
+
+//=================================================================================================
+//  Simulation::WriteChunkedSnapshotFile
+/// Write hydro and N-body particle data to a chunked snapshot file (see ChunkedSnapshot.h).
+/// Each field is written as a separate array of particles in memory order (i.e. the order of
+/// the last tree build, so consecutive particles, and therefore the particles in one chunk, are
+/// close together in space, which gives small chunk bounding boxes and compresses well).
+//=================================================================================================
+template <int ndim>
+bool Simulation<ndim>::WriteChunkedSnapshotFile(string filename)
+{
+  int k;                               // Dimension counter
+  int n;                               // No. of live particles gathered
+  int Nlivehydro = 0;                  // No. of live (i.e. not-accreted) hydro particles
+  int codec;                           // Codec used for compressing chunks
+  vector<FLOAT> values;                // Field values of all particles
+  vector<int> ivalues;                 // Integer field values of all particles
+  static const string rnames[3] = {"x", "y", "z"};
+  static const string vnames[3] = {"vx", "vy", "vz"};
+
+  debug2("[Simulation::WriteChunkedSnapshotFile]");
+
+#ifdef MPI_PARALLEL
+  ExceptionHandler::getIstance().raise("Chunked snapshot files are not supported with MPI");
+#endif
+
+  cout << "Writing snapshot file : " << filename << endl;
+
+  const string compression = simparams->stringparams["snap_compression"];
+  if (compression == "none") {
+    codec = codec_none;
+  }
+  else if (compression == "shuffle_lz") {
+    codec = codec_shuffle_lz;
+  }
+  else {
+    ExceptionHandler::getIstance().raise("Unrecognised parameter : snap_compression = " +
+                                         compression);
+    codec = codec_none;
+  }
+
+  ChunkedSnapshotWriter writer(filename, ndim, simparams->intparams["snap_chunk_size"], codec);
+
+  for (int i=0; i<hydro->Nhydro; i++) {
+    Particle<ndim>& part = hydro->GetParticlePointer(i);
+    if (part.flags.is_dead()) continue;
+    Nlivehydro++;
+    switch (part.ptype) {
+      case icm_type:
+        writer.idata[5]++; break;
+      case gas_type:
+        writer.idata[6]++; break;
+      case cdm_type:
+        writer.idata[7]++; break;
+      case dust_type:
+        writer.idata[8]++; break;
+      default:
+        ExceptionHandler::getIstance().raise("ChunkedWriter: Type not recognised");
+    }
+  }
+
+  // Set important header information
+  writer.idata[0]   = Nlivehydro;
+  writer.idata[1]   = nbody->Nstar;
+  writer.ilpdata[0] = Noutsnap;
+  writer.ilpdata[1] = Nsteps;
+  writer.ilpdata[2] = Noutlitesnap;
+  writer.ddata[0]   = t*simunits.t.outscale;
+  writer.ddata[1]   = tsnaplast*simunits.t.outscale;
+  writer.ddata[2]   = hydro->mmean*simunits.m.outscale;
+  writer.ddata[3]   = tlitesnaplast*simunits.t.outscale;
+
+  values.resize(max(Nlivehydro, nbody->Nstar));
+  ivalues.resize(Nlivehydro);
+
+
+  // Hydro particles
+  //-----------------------------------------------------------------------------------------------
+  if (Nlivehydro > 0) {
+    n = 0;
+    for (int i=0; i<hydro->Nhydro; i++) {
+      Particle<ndim>& part = hydro->GetParticlePointer(i);
+      if (!part.flags.is_dead()) ivalues[n++] = part.iorig;
+    }
+    writer.WriteField("iorig", "", chunked_hydro, &ivalues[0], Nlivehydro);
+
+    n = 0;
+    for (int i=0; i<hydro->Nhydro; i++) {
+      Particle<ndim>& part = hydro->GetParticlePointer(i);
+      if (!part.flags.is_dead()) ivalues[n++] = part.ptype;
+    }
+    writer.WriteField("ptype", "", chunked_hydro, &ivalues[0], Nlivehydro);
+
+    for (k=0; k<ndim; k++) {
+      n = 0;
+      for (int i=0; i<hydro->Nhydro; i++) {
+        Particle<ndim>& part = hydro->GetParticlePointer(i);
+        if (!part.flags.is_dead()) values[n++] = part.r[k]*simunits.r.outscale;
+      }
+      writer.WriteField(rnames[k], simunits.r.outunit, chunked_hydro, &values[0], Nlivehydro, k);
+    }
+
+    for (k=0; k<ndim; k++) {
+      n = 0;
+      for (int i=0; i<hydro->Nhydro; i++) {
+        Particle<ndim>& part = hydro->GetParticlePointer(i);
+        if (!part.flags.is_dead()) values[n++] = part.v[k]*simunits.v.outscale;
+      }
+      writer.WriteField(vnames[k], simunits.v.outunit, chunked_hydro, &values[0], Nlivehydro);
+    }
+
+    n = 0;
+    for (int i=0; i<hydro->Nhydro; i++) {
+      Particle<ndim>& part = hydro->GetParticlePointer(i);
+      if (!part.flags.is_dead()) values[n++] = part.m*simunits.m.outscale;
+    }
+    writer.WriteField("m", simunits.m.outunit, chunked_hydro, &values[0], Nlivehydro);
+
+    n = 0;
+    for (int i=0; i<hydro->Nhydro; i++) {
+      Particle<ndim>& part = hydro->GetParticlePointer(i);
+      if (!part.flags.is_dead()) values[n++] = part.h*simunits.r.outscale;
+    }
+    writer.WriteField("h", simunits.r.outunit, chunked_hydro, &values[0], Nlivehydro);
+
+    n = 0;
+    for (int i=0; i<hydro->Nhydro; i++) {
+      Particle<ndim>& part = hydro->GetParticlePointer(i);
+      if (!part.flags.is_dead()) values[n++] = part.rho*simunits.rho.outscale;
+    }
+    writer.WriteField("rho", simunits.rho.outunit, chunked_hydro, &values[0], Nlivehydro);
+
+    n = 0;
+    for (int i=0; i<hydro->Nhydro; i++) {
+      Particle<ndim>& part = hydro->GetParticlePointer(i);
+      if (!part.flags.is_dead()) values[n++] = part.u*simunits.u.outscale;
+    }
+    writer.WriteField("u", simunits.u.outunit, chunked_hydro, &values[0], Nlivehydro);
+  }
+
+
+  // Sinks/stars
+  //-----------------------------------------------------------------------------------------------
+  if (nbody->Nstar > 0) {
+    for (k=0; k<ndim; k++) {
+      for (int i=0; i<nbody->Nstar; i++) {
+        values[i] = nbody->stardata[i].r[k]*simunits.r.outscale;
+      }
+      writer.WriteField(rnames[k], simunits.r.outunit, chunked_star, &values[0], nbody->Nstar, k);
+    }
+    for (k=0; k<ndim; k++) {
+      for (int i=0; i<nbody->Nstar; i++) {
+        values[i] = nbody->stardata[i].v[k]*simunits.v.outscale;
+      }
+      writer.WriteField(vnames[k], simunits.v.outunit, chunked_star, &values[0], nbody->Nstar);
+    }
+    for (int i=0; i<nbody->Nstar; i++) values[i] = nbody->stardata[i].m*simunits.m.outscale;
+    writer.WriteField("m", simunits.m.outunit, chunked_star, &values[0], nbody->Nstar);
+    for (int i=0; i<nbody->Nstar; i++) values[i] = nbody->stardata[i].h*simunits.r.outscale;
+    writer.WriteField("h", simunits.r.outunit, chunked_star, &values[0], nbody->Nstar);
+    for (int i=0; i<nbody->Nstar; i++) {
+      values[i] = nbody->stardata[i].radius*simunits.r.outscale;
+    }
+    writer.WriteField("radius", simunits.r.outunit, chunked_star, &values[0], nbody->Nstar);
+  }
+  //-----------------------------------------------------------------------------------------------
+
+  return writer.Close();
+}
+
+
+
 //=================================================================================================
 //  Simulation::ConvertToCodeUnits
 /// For any simulations loaded into memory via a snapshot file, all particle
@@ -23,7 +23,14 @@
 
 #include <ctime>
 #include <cstdio>
+#include <cstring>
 #include <iostream>
+#include <sstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "ChunkedSnapshot.h"
 #include "Exception.h"
 #include "SphSnapshot.h"
 #include "Sph.h"
@@ -68,13 +75,30 @@ SphSnapshotBase* SphSnapshotBase::SphSnapshotFactory
 SphSnapshotBase::SphSnapshotBase(SimUnits* _units, string auxfilename): units(_units)
 {
   allocated        = false;
+  regionselected   = false;
   t                = 0.0;
   LastUsed         = time(NULL);
+  mapreader        = NULL;
+  mapping          = NULL;
+  mapsize          = 0;
+  for (int k=0; k<3; k++) rselmin[k] = -big_number;
+  for (int k=0; k<3; k++) rselmax[k] = big_number;
   if (auxfilename != "") filename = auxfilename;
 }
 
 
 
+//=================================================================================================
+//  SphSnapshotBase::~SphSnapshotBase
+/// Destructor for SphSnapshotBase class.
+//=================================================================================================
+SphSnapshotBase::~SphSnapshotBase()
+{
+  UnmapFile();
+}
+
+
+
 //=================================================================================================
 //  SphSnapshot::SphSnapshot
 /// Constructor for SphSnapshot class.
@@ -183,12 +207,34 @@ void SphSnapshotBase::DeallocateBufferMemory(void)
   for (DataIterator it=data.begin(); it != data.end(); it++) {
     it->second.DeallocateMemory();
   }
+  UnmapFile();
 
   allocated = false;
   return;
 }
 
 
+
+//=================================================================================================
+//  SphSnapshotBase::UnmapFile
+/// Release the memory-mapped snapshot file (if any) and all fields pointing into it.
+//=================================================================================================
+void SphSnapshotBase::UnmapFile(void)
+{
+  for (DataIterator it=data.begin(); it != data.end(); it++) {
+    it->second.mapped.clear();
+  }
+  if (mapping != NULL) munmap(mapping, mapsize);
+  delete mapreader;
+  mapreader = NULL;
+  mapping   = NULL;
+  mapsize   = 0;
+  mapptype.clear();
+
+  return;
+}
+
+
 //=================================================================================================
 //  SphSnapshotBase::CalculateMemoryUsage
 /// Returns no. of bytes allocated for current snapshot.
@@ -236,6 +282,7 @@ void SphSnapshot<ndims>::CopyDataFromSimulation()
   debug2("[SphSnapshotBase::CopyDataFromSimulation]");
 
   // Reset the species
+  UnmapFile();
   _species.clear();
   data.clear();
 
@@ -471,6 +518,274 @@ int SphSnapshotBase::GetNparticlesType(string type)
 
 
 
+//=================================================================================================
+//  SphSnapshotBase::GetFieldUnit
+/// Returns pointer to the unit object of the given field (or NULL if not recognised).
+//=================================================================================================
+SimUnit* SphSnapshotBase::GetFieldUnit
+ (string name)                         ///< Name of field
+{
+  if (name == "x" || name == "y" || name == "z" || name == "h" || name == "sma") {
+    return &(units->r);
+  }
+  else if (name == "iorig" || name == "ecc" || name == "qbin") {
+    return &(units->nounits);
+  }
+  else if (name == "vx" || name == "vy" || name == "vz") {
+    return &(units->v);
+  }
+  else if (name == "ax" || name == "ay" || name == "az") {
+    return &(units->a);
+  }
+  else if (name == "m" || name == "mbin") {
+    return &(units->m);
+  }
+  else if (name == "rho") {
+    return &(units->rho);
+  }
+  else if (name == "u") {
+    return &(units->u);
+  }
+  else if (name == "dudt") {
+    return &(units->dudt);
+  }
+  else if (name == "period") {
+    return &(units->t);
+  }
+  else if (name == "gpot") {
+    return &(units->E);
+  }
+  return NULL;
+}
+
+
+
+//=================================================================================================
+//  SphSnapshotBase::IsFieldSelected
+/// Returns true if the given field should be read (i.e. all fields if none are selected).
+//=================================================================================================
+bool SphSnapshotBase::IsFieldSelected
+ (string name)                         ///< Name of field
+{
+  if (selectedfields.empty()) return true;
+  for (unsigned int i=0; i<selectedfields.size(); i++) {
+    if (selectedfields[i] == name) return true;
+  }
+  return false;
+}
+
+
+
+//=================================================================================================
+//  SphSnapshotBase::SelectFields
+/// Select the fields (as a space or comma separated list, e.g. "x y rho") that are read from
+/// the snapshot file; an empty list selects all fields.  Only the chunked format can read single
+/// fields directly from file.  Any data already in memory is released, so the snapshot is
+/// re-read with the new selection the next time it is used.
+//=================================================================================================
+void SphSnapshotBase::SelectFields
+ (string fieldlist)                    ///< List of names of fields to read
+{
+  string name;                         // Name of field
+
+  for (unsigned int i=0; i<fieldlist.size(); i++) {
+    if (fieldlist[i] == ',') fieldlist[i] = ' ';
+  }
+  std::istringstream stream(fieldlist);
+  selectedfields.clear();
+  while (stream >> name) selectedfields.push_back(name);
+
+  // Remove all fields that are not selected, so the predicted memory usage is correct
+  for (DataIterator it=data.begin(); it != data.end(); it++) {
+    Species::maptype& values = it->second.values;
+    for (Species::maptype::iterator jt=values.begin(); jt != values.end();) {
+      if (IsFieldSelected(jt->first)) ++jt;
+      else values.erase(jt++);
+    }
+  }
+  if (allocated) DeallocateBufferMemory();
+
+  return;
+}
+
+
+
+//=================================================================================================
+//  SphSnapshotBase::SelectRegion
+/// Select the region (in the units of the snapshot file) of the particles that are read from
+/// the snapshot file.  Only the chunked format can read particles in a region directly from file,
+/// skipping all chunks whose bounding box lies outside the region.  Any data already in memory
+/// is released, so the snapshot is re-read with the new selection the next time it is used.
+//=================================================================================================
+void SphSnapshotBase::SelectRegion
+ (double xmin,                         ///< Minimum x-extent of region
+  double xmax,                         ///< Maximum x-extent of region
+  double ymin,                         ///< Minimum y-extent of region
+  double ymax,                         ///< Maximum y-extent of region
+  double zmin,                         ///< Minimum z-extent of region
+  double zmax)                         ///< Maximum z-extent of region
+{
+  rselmin[0] = xmin;  rselmax[0] = xmax;
+  rselmin[1] = ymin;  rselmax[1] = ymax;
+  rselmin[2] = zmin;  rselmax[2] = zmax;
+  regionselected = true;
+  if (allocated) DeallocateBufferMemory();
+
+  return;
+}
+
+
+
+//=================================================================================================
+//  SphSnapshotBase::SelectedFieldNames
+/// Returns the names of all selected fields stored for the given species (i.e. the same fields
+/// as recorded by CopyDataFromSimulation).
+//=================================================================================================
+void SphSnapshotBase::SelectedFieldNames
+ (string type,                         ///< [in] Particle type
+  vector<string> &names)               ///< [out] Names of selected fields
+{
+  static const string rnames[3] = {"x", "y", "z"};
+  static const string vnames[3] = {"vx", "vy", "vz"};
+  static const string anames[3] = {"ax", "ay", "az"};
+  vector<string> allnames;
+
+  for (int k=0; k<ndim; k++) {
+    allnames.push_back(rnames[k]);
+    allnames.push_back(vnames[k]);
+    allnames.push_back(anames[k]);
+  }
+  allnames.push_back("gpot");
+  allnames.push_back("m");
+  allnames.push_back("h");
+  if (type == "sph" || type == "dust") {
+    allnames.push_back("iorig");
+    allnames.push_back("rho");
+  }
+  if (type == "sph") {
+    allnames.push_back("u");
+    allnames.push_back("dudt");
+  }
+
+  names.clear();
+  for (unsigned int i=0; i<allnames.size(); i++) {
+    if (IsFieldSelected(allnames[i])) names.push_back(allnames[i]);
+  }
+
+  return;
+}
+
+
+
+//=================================================================================================
+//  SphSnapshotBase::IsFieldLoaded
+/// Returns true if the given field is in memory (either read or used directly from the
+/// memory-mapped file).
+//=================================================================================================
+bool SphSnapshotBase::IsFieldLoaded
+ (string type,                         ///< Particle type
+  string name)                         ///< Name of field
+{
+  Species &species = data[type];
+  return (species.mapped.count(name) > 0 ||
+          (species.values.count(name) > 0 && (int) species.values[name].size() == species.N));
+}
+
+
+
+//=================================================================================================
+//  SphSnapshotBase::LoadMappedField
+/// Make a field of a memory-mapped chunked snapshot available.  If the field is stored
+/// uncompressed and contiguously in the file, with the precision of the snapshot buffer and in
+/// code units (and does not need to be split into gas and dust), the field is used directly from
+/// the mapping without any copy.  Otherwise it is decompressed and/or converted into the snapshot
+/// buffer, which only happens once the field is actually requested.
+//=================================================================================================
+void SphSnapshotBase::LoadMappedField
+ (string type,                         ///< Particle type
+  string name)                         ///< Name of field
+{
+  Species &species = data[type];
+  vector<SNAPFLOAT> &out = species.values[name];
+  const int s = (type == "star") ? chunked_star : chunked_hydro;
+  const int ifield = mapreader->FindField(name, s);
+  const bool split = (s == chunked_hydro && mapptype.size() > 0);
+
+  debug2("[SphSnapshotBase::LoadMappedField]");
+
+  // Fields not stored in the file (e.g. accelerations) are set to zero
+  if (ifield == -1) {
+    out.assign(species.N, 0.0);
+    return;
+  }
+
+  const ChunkedSnapshotField &field = mapreader->fields[ifield];
+  const int elsize = (field.datatype == chunked_int) ? (int) sizeof(int) : mapreader->precision;
+  const SimUnit *unit = GetFieldUnit(name);
+  const bool codeunits = (field.datatype == chunked_int || unit->inscale == 1.0);
+
+  // Check all chunks lie inside the file
+  for (unsigned int ichunk=0; ichunk<field.offset.size(); ichunk++) {
+    if (field.offset[ichunk] < 0 || field.nbytes[ichunk] < 0 ||
+        (size_t) (field.offset[ichunk] + field.nbytes[ichunk]) > mapsize) {
+      ExceptionHandler::getIstance().raise("Corrupted chunk in chunked snapshot file (field " +
+                                           name + ")");
+    }
+  }
+
+  // Use the field directly from the mapping if possible
+  bool direct = (!split && codeunits && elsize == (int) sizeof(SNAPFLOAT) &&
+                 field.offset.size() > 0 && field.offset[0] % sizeof(SNAPFLOAT) == 0);
+  for (unsigned int ichunk=0; ichunk<field.offset.size() && direct; ichunk++) {
+    if (field.codec[ichunk] != codec_none) direct = false;
+    if (ichunk > 0 && field.offset[ichunk] != field.offset[ichunk-1] + field.nbytes[ichunk-1]) {
+      direct = false;
+    }
+  }
+  if (direct) {
+    species.mapped[name] = reinterpret_cast<SNAPFLOAT*>(mapping + field.offset[0]);
+    return;
+  }
+
+  // Otherwise decompress and convert each chunk into the snapshot buffer
+  const double scale = codeunits ? 1.0 : 1.0/unit->inscale;
+  vector<char> raw;
+  int n = 0;
+  out.resize(species.N);
+
+  for (unsigned int ichunk=0; ichunk<field.offset.size(); ichunk++) {
+    const int i0     = ichunk*mapreader->idata[2];
+    const int N      = mapreader->ChunkLength(s, ichunk);
+    const int nbytes = N*elsize;
+    raw.resize(max(nbytes, 1));
+    if (!ChunkedDecompress(mapping + field.offset[ichunk], field.nbytes[ichunk], elsize,
+                           field.codec[ichunk], &raw[0], nbytes)) {
+      ExceptionHandler::getIstance().raise("Corrupted chunk in chunked snapshot file (field " +
+                                           name + ")");
+    }
+
+    for (int i=0; i<N; i++) {
+      if (split && (mapptype[i0 + i] == dust_type) != (type == "dust")) continue;
+      if (n >= species.N) break;
+      if (field.datatype == chunked_int) {
+        SNAPFLOAT aux = 0.0;
+        memcpy(&aux, &raw[i*elsize], sizeof(int));
+        out[n++] = aux;
+      }
+      else if (elsize == (int) sizeof(double)) {
+        out[n++] = (SNAPFLOAT) (reinterpret_cast<double*>(&raw[0])[i]*scale);
+      }
+      else {
+        out[n++] = (SNAPFLOAT) (reinterpret_cast<float*>(&raw[0])[i]*scale);
+      }
+    }
+  }
+
+  return;
+}
+
+
+
 //=================================================================================================
 //  SphSnapshotBase::ExtractArray
 /// Returns pointer to required array stored in snapshot buffer memory.
@@ -523,76 +838,31 @@ UnitInfo SphSnapshotBase::ExtractArray
     ExceptionHandler::getIstance().raise(message);
   }
 
-  *out_array=&(data[type].values[name][0]);
-
   // If array type and name is valid, pass pointer to array and also set unit
-  if (name == "x") {
-    unit = &(units->r);
-  }
-  else if (name == "iorig") {
-	  unit = &(units->nounits);
-  }
-  else if (name == "y") {
-    unit = &(units->r);
-  }
-  else if (name == "z") {
-    unit = &(units->r);
-  }
-  else if (name == "vx") {
-    unit = &(units->v);
-  }
-  else if (name == "vy") {
-    unit = &(units->v);
-  }
-  else if (name == "vz") {
-    unit = &(units->v);
-  }
-  else if (name == "ax") {
-    unit = &(units->a);
-  }
-  else if (name == "ay") {
-    unit = &(units->a);
-  }
-  else if (name == "az") {
-    unit = &(units->a);
-  }
-  else if (name == "m") {
-    unit = &(units->m);
-  }
-  else if (name == "h") {
-    unit = &(units->r);
-  }
-  else if (name == "rho") {
-    unit = &(units->rho);
-  }
-  else if (name == "u") {
-    unit = &(units->u);
-  }
-  else if (name == "dudt") {
-    unit = &(units->dudt);
-  }
-  else if (name == "ecc") {
-    unit = &(units->nounits);
-  }
-  else if (name == "mbin") {
-    unit = &(units->m);
-  }
-  else if (name == "period") {
-    unit = &(units->t);
+  unit = GetFieldUnit(name);
+  if (unit == 0) {
+    string message = "Warning: the selected array: " + name + " has not been recognized";
+    ExceptionHandler::getIstance().raise(message);
+    *size_array = 0;
   }
-  else if (name == "qbin") {
-    unit = &(units->nounits);
+
+  // Check the array has been read (i.e. it was not excluded by SelectFields)
+  if (data[type].values.count(name) == 0 && !IsFieldSelected(name)) {
+    string message = "Error: the array " + name + " has not been read from the snapshot; "
+      "select it with SelectFields before reading the snapshot";
+    ExceptionHandler::getIstance().raise(message);
   }
-  else if (name == "sma") {
-    unit = &(units->r);
+
+  // Fields of memory-mapped files are only made available once requested
+  if (mapping != NULL && data[type].values.count(name) > 0 && !IsFieldLoaded(type, name)) {
+    LoadMappedField(type, name);
   }
-  else if (name == "gpot") {
-    unit = &(units->E);
+
+  if (data[type].mapped.count(name) > 0) {
+    *out_array = data[type].mapped[name];
   }
   else {
-    string message = "Warning: the selected array: " + name + " has not been recognized";
-    ExceptionHandler::getIstance().raise(message);
-    *size_array = 0;
+    *out_array=&(data[type].values[name][0]);
   }
 
 
@@ -643,6 +913,18 @@ void SphSnapshot<ndims>::ReadSnapshot(string format)
   // Set pointer to units object
   units = &(simulation->simunits);
 
+  // Chunked snapshots are read directly into the snapshot buffer (or memory-mapped)
+  UnmapFile();
+  if (format == "chunked" || format == "gandalf_chunked") {
+    if (simulation->simparams->intparams["snap_mmap"] == 1 && !regionselected) {
+      MapChunkedSnapshot();
+    }
+    else {
+      ReadChunkedSnapshot();
+    }
+    return;
+  }
+
   // Read simulation into main memory
   simulation->ReadSnapshotFile(filename, format);
 
@@ -660,3 +942,223 @@ void SphSnapshot<ndims>::ReadSnapshot(string format)
 
   return;
 }
+
+
+
+//=================================================================================================
+//  SphSnapshot::ReadChunkedSnapshot
+/// Read a chunked snapshot file directly into the snapshot buffer, without going through the
+/// main simulation arrays.  Only the fields selected with SelectFields are read and, if a region
+/// is selected with SelectRegion, only the chunks whose bounding box overlaps the region are
+/// read and decompressed (and only the particles inside the region are kept).  Fields that are
+/// not stored in the file (e.g. accelerations) are set to zero.
+//=================================================================================================
+template <int ndims>
+void SphSnapshot<ndims>::ReadChunkedSnapshot(void)
+{
+  int ifield;                          // Index of field in file
+  ChunkedSnapshotReader reader;        // Chunked snapshot file reader
+  vector<int> ptype;                   // Particle types of current chunk
+  vector<char> keep;                   // Flag if particle of chunk is inside region
+  vector<double> values;               // Field values of current chunk
+  vector<double> rchunk[ndims];        // Positions of particles in current chunk
+  static const string rnames[3] = {"x", "y", "z"};
+
+  debug2("[SphSnapshot::ReadChunkedSnapshot]");
+
+  if (!reader.Open(filename)) {
+    ExceptionHandler::getIstance().raise("Could not open snapshot file " + filename);
+  }
+  if (reader.ndim != ndims) {
+    std::ostringstream stream;
+    stream << "Incorrect NDIM in file " << filename << " : got " << reader.ndim
+           << ", expected " << ndims << endl;
+    ExceptionHandler::getIstance().raise(stream.str());
+  }
+
+  // Recalculate input units if required
+  units->SetupUnits(simulation->simparams);
+  t = reader.ddata[0]/units->t.inscale;
+
+  _species.clear();
+  data.clear();
+
+
+  // Loop over both species stored in the file (hydro particles are split into gas and dust)
+  //-----------------------------------------------------------------------------------------------
+  for (int s=0; s<chunked_Nspecies; s++) {
+    const int Nchunks = (reader.idata[s == chunked_hydro ? 0 : 1] > 0) ? reader.Nchunks(s) : 0;
+    const string species[2] = {s == chunked_hydro ? "sph" : "star", "dust"};
+    vector<string> names[2];
+
+    SelectedFieldNames(species[0], names[0]);
+    SelectedFieldNames(species[1], names[1]);
+
+    for (int ichunk=0; ichunk<Nchunks; ichunk++) {
+      const int N = reader.ChunkLength(s, ichunk);
+      int Nkeep[2] = {0, 0};
+
+      // Skip chunks outside the selected region, and find the particles inside the region
+      keep.assign(N, 1);
+      if (regionselected) {
+        if (!reader.ChunkOverlapsBox(s, ichunk, rselmin, rselmax)) continue;
+        for (int k=0; k<ndims; k++) {
+          if ((ifield = reader.FindField(rnames[k], s)) == -1) continue;
+          rchunk[k].resize(N);
+          reader.ReadFieldChunk(ifield, ichunk, &rchunk[k][0]);
+          for (int i=0; i<N; i++) {
+            if (rchunk[k][i] < rselmin[k] || rchunk[k][i] > rselmax[k]) keep[i] = 0;
+          }
+        }
+      }
+
+      // Find the species of each particle
+      ptype.assign(N, gas_type);
+      if (s == chunked_hydro && (ifield = reader.FindField("ptype", s)) != -1) {
+        reader.ReadFieldChunk(ifield, ichunk, &ptype[0]);
+      }
+      for (int i=0; i<N; i++) {
+        if (keep[i]) Nkeep[ptype[i] == dust_type ? 1 : 0]++;
+      }
+
+      // Read all selected fields of the chunk and convert them to code units
+      values.resize(N);
+      for (int j=0; j<2; j++) {
+        if (Nkeep[j] == 0) continue;
+        Species::maptype& spvalues = data[species[j]].values;
+        data[species[j]].name = species[j];
+        data[species[j]].N += Nkeep[j];
+
+        for (unsigned int f=0; f<names[j].size(); f++) {
+          const string &name = names[j][f];
+          vector<SNAPFLOAT> &out = spvalues[name];
+          ifield = reader.FindField(name, s);
+
+          if (ifield == -1) {
+            out.resize(out.size() + Nkeep[j], 0.0);
+          }
+          else if (name == "iorig") {
+            vector<int> iorig(N);
+            reader.ReadFieldChunk(ifield, ichunk, &iorig[0]);
+            for (int i=0; i<N; i++) {
+              if (!keep[i] || (ptype[i] == dust_type) != (j == 1)) continue;
+              SNAPFLOAT aux = 0.0;
+              memcpy(&aux, &iorig[i], sizeof(int));
+              out.push_back(aux);
+            }
+          }
+          else {
+            const double scale = 1.0/GetFieldUnit(name)->inscale;
+            reader.ReadFieldChunk(ifield, ichunk, &values[0]);
+            for (int i=0; i<N; i++) {
+              if (!keep[i] || (ptype[i] == dust_type) != (j == 1)) continue;
+              out.push_back((SNAPFLOAT) (values[i]*scale));
+            }
+          }
+        }
+      }
+
+    }
+
+    for (int j=0; j<(s == chunked_hydro ? 2 : 1); j++) {
+      if (data.count(species[j]) > 0) _species.push_back(species[j]);
+    }
+  }
+  //-----------------------------------------------------------------------------------------------
+
+  reader.Close();
+
+  LastUsed  = time(NULL);
+  allocated = true;
+
+  return;
+}
+
+
+
+//=================================================================================================
+//  SphSnapshot::MapChunkedSnapshot
+/// Memory-map a chunked snapshot file instead of reading it.  Only the index of the file is read
+/// here; each field is only made available (see LoadMappedField) once it is requested by
+/// ExtractArray, either directly from the mapping or by converting it into the snapshot buffer.
+/// Falls back to reading the file if it cannot be mapped.
+//=================================================================================================
+template <int ndims>
+void SphSnapshot<ndims>::MapChunkedSnapshot(void)
+{
+  int fd;                              // File descriptor of snapshot file
+  struct stat filestat;                // File information (i.e. size)
+
+  debug2("[SphSnapshot::MapChunkedSnapshot]");
+
+  mapreader = new ChunkedSnapshotReader();
+  if (!mapreader->Open(filename)) {
+    ExceptionHandler::getIstance().raise("Could not open snapshot file " + filename);
+  }
+  mapreader->Close();
+  if (mapreader->ndim != ndims) {
+    std::ostringstream stream;
+    stream << "Incorrect NDIM in file " << filename << " : got " << mapreader->ndim
+           << ", expected " << ndims << endl;
+    ExceptionHandler::getIstance().raise(stream.str());
+  }
+
+  // Map the complete file (read-only, so all pages are shared with the page cache)
+  fd = open(filename.c_str(), O_RDONLY);
+  if (fd != -1 && fstat(fd, &filestat) == 0 && filestat.st_size > 0) {
+    mapsize = filestat.st_size;
+    void *addr = mmap(NULL, mapsize, PROT_READ, MAP_SHARED, fd, 0);
+    if (addr != MAP_FAILED) mapping = static_cast<char*>(addr);
+  }
+  if (fd != -1) close(fd);
+  if (mapping == NULL) {
+    UnmapFile();
+    ReadChunkedSnapshot();
+    return;
+  }
+
+  // Recalculate input units if required
+  units->SetupUnits(simulation->simparams);
+  t = mapreader->ddata[0]/units->t.inscale;
+
+  _species.clear();
+  data.clear();
+
+  // Create all species and (empty) selected fields
+  const string species[3] = {"sph", "dust", "star"};
+  const int Nspecies[3] = {mapreader->idata[0] - mapreader->idata[8], mapreader->idata[8],
+                           mapreader->idata[1]};
+  for (int j=0; j<3; j++) {
+    vector<string> names;
+    if (Nspecies[j] == 0) continue;
+    _species.push_back(species[j]);
+    data[species[j]] = Species(Nspecies[j], species[j]);
+    SelectedFieldNames(species[j], names);
+    for (unsigned int i=0; i<names.size(); i++) {
+      data[species[j]].values[names[i]] = vector<SNAPFLOAT>();
+    }
+  }
+
+  // If the file contains both gas and dust, the types are needed to split each field
+  const int iptype = mapreader->FindField("ptype", chunked_hydro);
+  if (Nspecies[0] > 0 && Nspecies[1] > 0 && iptype != -1) {
+    mapptype.resize(mapreader->idata[0]);
+    for (int ichunk=0; ichunk<mapreader->Nchunks(chunked_hydro); ichunk++) {
+      const ChunkedSnapshotField &field = mapreader->fields[iptype];
+      const int nbytes = mapreader->ChunkLength(chunked_hydro, ichunk)*sizeof(int);
+      if ((size_t) (field.offset[ichunk] + field.nbytes[ichunk]) > mapsize ||
+          !ChunkedDecompress(mapping + field.offset[ichunk], field.nbytes[ichunk], sizeof(int),
+                             field.codec[ichunk],
+                             reinterpret_cast<char*>(&mapptype[ichunk*mapreader->idata[2]]),
+                             nbytes)) {
+        ExceptionHandler::getIstance().raise("Corrupted chunk in chunked snapshot file "
+                                             "(field ptype)");
+      }
+    }
+  }
+
+  LastUsed  = time(NULL);
+  allocated = true;
+
+  return;
+}
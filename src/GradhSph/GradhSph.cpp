@@ -137,11 +137,17 @@ void GradhSph<ndim, kernelclass>::DeallocateMemory(void)
 /// Uses the previous value of h as a starting guess and then uses either a Newton-Rhapson solver,
 /// or fixed-point iteration, to converge on the correct value of h.  The maximum tolerance used
 /// for deciding whether the iteration has converged is given by the 'h_converge' parameter.
+/// The density sums only use the contiguous mass and distance arrays so that the inner loop can
+/// be vectorised (if compiled with GANDALF_SIMD).  The full neighbour data in 'ngbs' is only
+/// required for the Cullen & Dehnen viscosity switch and when creating sinks.
 //=================================================================================================
 template <int ndim, template<int> class kernelclass>
 int GradhSph<ndim, kernelclass>::ComputeH
  (SphParticle<ndim> &part,                                ///< [inout] Particle i data
-  FLOAT hmax,                                             ///< [in] Maximum smoothing length
+  const FLOAT hmax,                                       ///< [in] Maximum smoothing length
+  const int Nneib,                                        ///< [in] No. of potential neighbours
+  const FLOAT *m,                                         ///< [in] Array of neighbour masses
+  const FLOAT *drsqd,                                     ///< [in] Array of neib. distances sqd
   const vector<DensityParticle> &ngbs,                    ///< [in] Neighbour properties
   Nbody<ndim> *nbody)                                     ///< [in] Main N-body object
 {
@@ -154,9 +160,12 @@ int GradhSph<ndim, kernelclass>::ComputeH
   FLOAT h_upper_bound = hmax;          // Upper bound on h
   FLOAT invh;                          // 1 / h
   FLOAT invhsqd;                       // (1 / h)^2
+  FLOAT invomega;                      // Local sum for the omega correction term
   FLOAT invrho;                        // 1 / rho
+  FLOAT rho;                           // Local sum for the density
   FLOAT rho_hmin = (FLOAT) 0.0;        // ..
   FLOAT ssqd;                          // Kernel parameter squared, (r/h)^2
+  FLOAT zeta;                          // Local sum for the zeta correction term
   GradhSphParticle<ndim>& parti = static_cast<GradhSphParticle<ndim>& > (part);
 
 
@@ -169,8 +178,6 @@ int GradhSph<ndim, kernelclass>::ComputeH
   }
   rho_hmin = (FLOAT) 0.0;
 
-  int Nneib = ngbs.size();
-
   // Some basic sanity-checking in case of invalid input into routine
   assert(Nneib > 0);
   assert(hmax > (FLOAT) 0.0);
@@ -186,27 +193,28 @@ int GradhSph<ndim, kernelclass>::ComputeH
     // Initialise all variables for this value of h
     iteration++;
     invh           = (FLOAT) 1.0/parti.h;
-    parti.rho      = (FLOAT) 0.0;
-    parti.invomega = (FLOAT) 0.0;
-    parti.zeta     = (FLOAT) 0.0;
+    rho            = (FLOAT) 0.0;
+    invomega       = (FLOAT) 0.0;
+    zeta           = (FLOAT) 0.0;
     parti.hfactor  = pow(invh,ndim);
     invhsqd        = invh*invh;
 
     // Loop over all nearest neighbours in list to calculate density, omega and zeta.
     //---------------------------------------------------------------------------------------------
+#if defined(GANDALF_SIMD)
+#pragma omp simd reduction(+:rho,invomega,zeta) private(ssqd)
+#endif
     for (j=0; j<Nneib; j++) {
-      const DensityParticle &ngb = ngbs[j];
-      for (k=0; k<ndim; k++) dr[k] = ngb.r[k] - parti.r[k];
-      ssqd           = invhsqd*DotProduct(dr, dr, ndim);
-      parti.rho      += ngb.m*kern.w0_s2(ssqd);
-      parti.invomega += ngb.m*invh*kern.womega_s2(ssqd);
-      parti.zeta     += ngb.m*kern.wzeta_s2(ssqd);
+      ssqd      = invhsqd*drsqd[j];
+      rho      += m[j]*kern.w0_s2(ssqd);
+      invomega += m[j]*invh*kern.womega_s2(ssqd);
+      zeta     += m[j]*kern.wzeta_s2(ssqd);
     }
     //---------------------------------------------------------------------------------------------
 
-    parti.rho      *= parti.hfactor;
-    parti.invomega *= parti.hfactor;
-    parti.zeta     *= invhsqd;
+    parti.rho      = rho*parti.hfactor;
+    parti.invomega = invomega*parti.hfactor;
+    parti.zeta     = zeta*invhsqd;
 
     // Density must at least equal its self-contribution
     // (failure could indicate neighbour list problem)
@@ -271,11 +279,8 @@ int GradhSph<ndim, kernelclass>::ComputeH
   if (create_sinks == 1) {
     parti.flags.set(potmin);
     for (j=0; j<Nneib; j++) {
-      const DensityParticle &ngb = ngbs[j];
-      FLOAT drsqd = DotProduct(dr,dr,ndim);
-      for (k=0; k<ndim; k++) dr[k] = ngb.r[k] - parti.r[k];
-      if (ngb.gpot > (FLOAT) 1.000000001*parti.gpot &&
-          drsqd*invhsqd < kern.kernrangesqd) parti.flags.unset(potmin);
+      if (ngbs[j].gpot > (FLOAT) 1.000000001*parti.gpot &&
+          drsqd[j]*invhsqd < kern.kernrangesqd) parti.flags.unset(potmin);
     }
   }
 
@@ -364,7 +369,7 @@ void GradhSph<ndim, kernelclass>::ComputeSphHydroForces
 {
   int k;                               // Dimension counter
   FLOAT alpha_mean;                    // Mean articial viscosity alpha value
-  FLOAT draux[ndim];                   // Relative position vector
+  KFLOAT draux[ndim];                  // Relative position vector
   FLOAT dvdr;                          // Dot product of dv and dr
   FLOAT wkerni;                        // Value of w1 kernel function for part i
   FLOAT wkernj;                        // Value of w1 kernel function for neighbour j
@@ -375,7 +380,7 @@ void GradhSph<ndim, kernelclass>::ComputeSphHydroForces
   // Some basic sanity-checking in case of invalid input into routine
   assert(!parti.flags.is_dead());
 
-  const FLOAT invh_i   = 1/parti.h;
+  const KFLOAT invh_i  = (KFLOAT) (1/parti.h);
   const FLOAT invrho_i = 1/parti.rho;
 
   // Loop over all potential neighbours in the list
@@ -384,11 +389,11 @@ void GradhSph<ndim, kernelclass>::ComputeSphHydroForces
   for (int j=0; j<Nneib; j++) {
     assert(!neibpart[j].flags.is_dead());
 
-    const FLOAT invh_j   = 1/neibpart[j].h;
+    const KFLOAT invh_j  = (KFLOAT) (1/neibpart[j].h);
     const FLOAT invrho_j = 1/neibpart[j].rho;
 
-    for (k=0; k<ndim; k++) draux[k] = neibpart[j].r[k]-parti.r[k];
-    const FLOAT drmag = sqrt(DotProduct(draux,draux,ndim));
+    for (k=0; k<ndim; k++) draux[k] = (KFLOAT) (neibpart[j].r[k]-parti.r[k]);
+    const KFLOAT drmag = sqrt(DotProduct(draux,draux,ndim));
     if (drmag>0) for (k=0; k<ndim; k++) draux[k] /= drmag;
 
     wkerni = parti.hfactor*kern.w1(drmag*invh_i);
@@ -449,6 +454,140 @@ void GradhSph<ndim, kernelclass>::ComputeSphHydroForces
   //-----------------------------------------------------------------------------------------------
 
   // Set velocity divergence and compressional heating rate terms
+  FinishSphHydroForces(parti);
+
+  return;
+}
+
+
+
+//=================================================================================================
+//  GradhSph::ComputeSymmetricSphHydroForces
+/// Compute SPH neighbour force pairs symmetrically.  The neighbour list must only contain the
+/// first appearance of each pair (i.e. obtained with do_pair_once), so that each pair-wise
+/// interaction is computed once and the equal-and-opposite contributions to the acceleration,
+/// velocity divergence and heating rate are added to the local copy of the neighbour.  The
+/// normalisation of div_v and the compressional heating term are not applied here, but in
+/// FinishSphHydroForces once all contributions have been summed.
+//=================================================================================================
+template <int ndim, template<int> class kernelclass>
+void GradhSph<ndim, kernelclass>::ComputeSymmetricSphHydroForces
+ (GradhSphParticle<ndim> &parti,                                   ///< [inout] Particle i data
+  NeighbourList<typename GradhSphBase<ndim>::HydroNeib>& neibpart) ///< [inout] Neighbour list
+{
+  int k;                               // Dimension counter
+  FLOAT alpha_mean;                    // Mean articial viscosity alpha value
+  KFLOAT draux[ndim];                  // Relative position vector
+  FLOAT dudt_visc;                     // Viscous heating rate (without mass)
+  FLOAT dvdr;                          // Dot product of dv and dr
+  FLOAT wkerni;                        // Value of w1 kernel function for part i
+  FLOAT wkernj;                        // Value of w1 kernel function for neighbour j
+  FLOAT vsignal;                       // Signal velocity
+  FLOAT paux;                          // Aux. pressure force variable
+  FLOAT winvrho;                       // 0.5*(wkerni + wkernj)*invrhomean
+
+  // Some basic sanity-checking in case of invalid input into routine
+  assert(!parti.flags.is_dead());
+
+  const KFLOAT invh_i  = (KFLOAT) (1/parti.h);
+  const FLOAT invrho_i = 1/parti.rho;
+  const FLOAT pterm_i  = (parti.pressure*parti.invomega)*invrho_i*invrho_i;
+
+  // Loop over all potential neighbours in the list
+  //-----------------------------------------------------------------------------------------------
+  int Nneib = neibpart.size() ;
+  for (int j=0; j<Nneib; j++) {
+    typename GradhSphBase<ndim>::HydroNeib& neibj = neibpart[j];
+    assert(!neibj.flags.is_dead());
+
+    const KFLOAT invh_j  = (KFLOAT) (1/neibj.h);
+    const FLOAT invrho_j = 1/neibj.rho;
+
+    for (k=0; k<ndim; k++) draux[k] = (KFLOAT) (neibj.r[k]-parti.r[k]);
+    const KFLOAT drmag = sqrt(DotProduct(draux,draux,ndim));
+    if (drmag>0) for (k=0; k<ndim; k++) draux[k] /= drmag;
+
+    wkerni = parti.hfactor*kern.w1(drmag*invh_i);
+    wkernj = neibj.hfactor*kern.w1(drmag*invh_j);
+
+    dvdr = DotProduct(neibj.v,draux, ndim);
+    dvdr -= DotProduct(parti.v,draux,ndim);
+
+    // Add contribution to velocity divergence
+    parti.div_v -= neibj.m*dvdr*wkerni;
+    neibj.div_v -= parti.m*dvdr*wkernj;
+
+    // Main SPH pressure force term
+    paux = pterm_i*wkerni + ((neibj.pressure*neibj.invomega)*invrho_j*invrho_j)*wkernj;
+
+    // Add dissipation terms (for approaching particle pairs)
+    //---------------------------------------------------------------------------------------------
+    if (dvdr < (FLOAT) 0.0) {
+
+      winvrho = (FLOAT) 0.25*(wkerni + wkernj)*(invrho_i + invrho_j);
+
+      // Artificial viscosity term
+      if (avisc == mon97) {
+        vsignal    = parti.sound + neibj.sound - beta_visc*alpha_visc*dvdr;
+        paux       -= alpha_visc*vsignal*dvdr*winvrho;
+        dudt_visc  = (FLOAT) 0.5*alpha_visc*vsignal*dvdr*dvdr*winvrho;
+        parti.dudt -= neibj.m*dudt_visc;
+        neibj.dudt -= parti.m*dudt_visc;
+      }
+      else if (avisc == mon97mm97 || avisc == mon97cd2010) {
+        alpha_mean = (FLOAT) 0.5*(parti.alpha + neibj.alpha);
+        vsignal    = parti.sound + neibj.sound - beta_visc*alpha_mean*dvdr;
+        paux       -= alpha_mean*vsignal*dvdr*winvrho;
+        dudt_visc  = (FLOAT) 0.5*alpha_mean*vsignal*dvdr*dvdr*winvrho;
+        parti.dudt -= neibj.m*dudt_visc;
+        neibj.dudt -= parti.m*dudt_visc;
+      }
+
+      // Artificial conductivity term
+      if (acond == wadsley2008) {
+        const FLOAT dudt_cond = dvdr*(neibj.u - parti.u)*(invrho_i*wkerni + invrho_j*wkernj);
+        parti.dudt += neibj.m*dudt_cond;
+        neibj.dudt -= parti.m*dudt_cond;
+      }
+      else if (acond == price2008) {
+        const FLOAT dudt_cond = (FLOAT) 0.5*(parti.u - neibj.u)*winvrho*(invrho_i + invrho_j)*
+          sqrt(fabs(parti.pressure - neibj.pressure));
+        parti.dudt += neibj.m*dudt_cond;
+        neibj.dudt -= parti.m*dudt_cond;
+      }
+
+    }
+    //---------------------------------------------------------------------------------------------
+
+    // Add total hydro contribution to acceleration for both particles
+    for (k=0; k<ndim; k++) {
+      parti.a[k] += neibj.m*draux[k]*paux;
+      neibj.a[k] -= parti.m*draux[k]*paux;
+      assert(parti.a[k]==parti.a[k]);
+    }
+    parti.levelneib = max(parti.levelneib,neibj.level);
+    neibj.levelneib = max(neibj.levelneib,parti.level);
+
+  }
+  //-----------------------------------------------------------------------------------------------
+
+  return;
+}
+
+
+
+//=================================================================================================
+//  GradhSph::FinishSphHydroForces
+/// Normalise the velocity divergence and add the compressional heating and time-dependent
+/// viscosity terms once all neighbour contributions to the hydro forces have been summed.
+//=================================================================================================
+template <int ndim, template<int> class kernelclass>
+void GradhSph<ndim, kernelclass>::FinishSphHydroForces
+ (GradhSphParticle<ndim> &parti)       ///< [inout] Particle i data
+{
+  const FLOAT invh_i   = 1/parti.h;
+  const FLOAT invrho_i = 1/parti.rho;
+
   parti.div_v    *= invrho_i;
   parti.dudt     -= eos->Pressure(parti)*parti.div_v*invrho_i*parti.invomega;
   if (tdavisc == mm97) {
@@ -56,7 +56,8 @@ GradhSphTree<ndim,ParticleType>::GradhSphTree
   ParticleTypeRegister& types):
  SphTree<ndim,ParticleType>
   (tree_type, _Nleafmax, _Nmpi, _pruning_level_min, _pruning_level_max, _thetamaxsqd,
-   _kernrange, _macerror, _gravity_mac, _multipole, _box, _kern, _timing, types)
+   _kernrange, _macerror, _gravity_mac, _multipole, _box, _kern, _timing, types),
+ symmetric_forces(false)
 {
 }
 
@@ -121,21 +122,25 @@ void GradhSphTree<ndim,ParticleType>::UpdateAllSphProperties
     int Ngather;                               // No. of gather neighbours
     int Nneib;                                 // No. of neighbours from tree-walk
     int okflag;                                // Flag if particle is done
-    FLOAT draux[ndim];                         // Aux. relative position vector var
-    FLOAT drsqdaux;                            // Distance squared
+    FLOAT draux;                               // Aux. relative position variable
     FLOAT hrangesqd;                           // Kernel extent
     FLOAT hmax;                                // Maximum smoothing length
     FLOAT rp[ndim];                            // Local copy of particle position
-    FLOAT *mu2 = 0;                            // Trimmed array (dummy for grad-h)
     int Nneibmax = Nneibmaxbuf[ithread];       // Local copy of neighbour buffer size
     int* activelist = activelistbuf[ithread];  // Local array of active particle ids
     int* neiblist = new int[Nneibmax];         // Local array of neighbour particle ids
     int* ptype    = new int[Nneibmax];         // Local array of particle types
-    vector<typename Sph<ndim>::DensityParticle> ngb;           // Local array of neighbour data
+    FLOAT* drsqd  = new FLOAT[Nneibmax];       // Local array of distances (squared)
+    FLOAT* drsqd2 = new FLOAT[Nneibmax];       // Local reduced array of distances (squared)
+    FLOAT* m      = new FLOAT[Nneibmax];       // Local array of particle masses
+    FLOAT* m2     = new FLOAT[Nneibmax];       // Local reduced array of neighbour masses
+    FLOAT* r      = new FLOAT[Nneibmax*ndim];  // Local array of positions (one block per dim.)
     vector<typename Sph<ndim>::DensityParticle> ngb2;          // Local array of reduced neighbour data
     ParticleType<ndim>* activepart = activepartbuf[ithread];   // Local array of active particles
 
-    ngb.resize(Nneibmax) ; ngb2.reserve(Nneibmax);
+    // The full neighbour data is only needed for the Cullen & Dehnen switch and for creating sinks
+    const bool ngbdata = (sph->tdavisc == cd2010 || sph->create_sinks == 1);
+    if (ngbdata) ngb2.reserve(Nneibmax);
 
 
     // Loop over all active cells
@@ -170,10 +175,22 @@ void GradhSphTree<ndim,ParticleType>::UpdateAllSphProperties
         // If there are too many neighbours so the buffers are filled,
         // reallocate the arrays and recompute the neighbour lists.
         while (Nneib == -1) {
+          delete[] r;
+          delete[] m2;
+          delete[] m;
+          delete[] drsqd2;
+          delete[] drsqd;
+          delete[] ptype;
           delete[] neiblist;
           Nneibmax = 2*Nneibmax;
           neiblist = new int[Nneibmax];
-          ngb.resize(Nneibmax);
+          ptype    = new int[Nneibmax];
+          drsqd    = new FLOAT[Nneibmax];
+          drsqd2   = new FLOAT[Nneibmax];
+          m        = new FLOAT[Nneibmax];
+          m2       = new FLOAT[Nneibmax];
+          r        = new FLOAT[Nneibmax*ndim];
+          if (ngbdata) ngb2.reserve(Nneibmax);
 
           Nneib = 0;
           Nneib = tree->ComputeGatherNeighbourList(cell,sphdata,hmax,Nneibmax,Nneib,neiblist);
@@ -184,10 +201,13 @@ void GradhSphTree<ndim,ParticleType>::UpdateAllSphProperties
 #endif
         };
 
-        // Make local copies of important neib information (mass and position)
+        // Make local copies of important neib information (mass and position), with the positions
+        // stored as separate contiguous arrays for each dimension
         for (jj=0; jj<Nneib; jj++) {
           j         = neiblist[jj];
-          ngb[jj] = typename Sph<ndim>::DensityParticle(sphdata[j]) ;
+          m[jj]     = sphdata[j].m;
+          ptype[jj] = sphdata[j].ptype;
+          for (k=0; k<ndim; k++) r[k*Nneibmax + jj] = sphdata[j].r[k];
         }
 
         // Loop over all active particles in the cell
@@ -198,22 +218,31 @@ void GradhSphTree<ndim,ParticleType>::UpdateAllSphProperties
 
           // Set gather range as current h multiplied by some tolerance factor
           hrangesqd = kernrangesqd*hmax*hmax;
-          ngb2.resize(0);
+          Ngather = 0;
+          ngb2.clear();
+
+          // Compute distance (squared) to all potential neighbours
+          for (jj=0; jj<Nneib; jj++) drsqd[jj] = (FLOAT) 0.0;
+          for (k=0; k<ndim; k++) {
+            const FLOAT *rk = r + k*Nneibmax;
+            for (jj=0; jj<Nneib; jj++) {
+              draux = rk[jj] - rp[k];
+              drsqd[jj] += draux*draux;
+            }
+          }
 
-          // Compute distance (squared) to all
+          // Record distance squared and masses for all potential gather neighbours
           //---------------------------------------------------------------------------------------
           for (jj=0; jj<Nneib; jj++) {
 
             // Only include particles of appropriate types in density calculation
-            if (!sph->types[activepart[j].ptype].hmask[ngb[jj].ptype]) continue;
-
+            if (!sph->types[activepart[j].ptype].hmask[ptype[jj]]) continue;
 
-            for (k=0; k<ndim; k++) draux[k] = ngb[jj].r[k] - rp[k];
-            drsqdaux = DotProduct(draux,draux,ndim) + small_number;
-
-            // Record distance squared and masses for all potential gather neighbours
-            if (drsqdaux <= hrangesqd) {
-              ngb2.push_back(ngb[jj]) ;
+            if (drsqd[jj] + small_number <= hrangesqd) {
+              if (ngbdata) ngb2.push_back(typename Sph<ndim>::DensityParticle(sphdata[neiblist[jj]]));
+              drsqd2[Ngather] = drsqd[jj];
+              m2[Ngather]     = m[jj];
+              Ngather++;
             }
 
           }
@@ -225,7 +254,7 @@ void GradhSphTree<ndim,ParticleType>::UpdateAllSphProperties
 #endif
 
           // Compute smoothing length and other gather properties for ptcl i
-          okflag = sph->ComputeH(activepart[j], hmax, ngb2, nbody);
+          okflag = sph->ComputeH(activepart[j], hmax, Ngather, m2, drsqd2, ngb2, nbody);
 
           // If h-computation is invalid, then break from loop and recompute
           // larger neighbour lists
@@ -248,6 +277,12 @@ void GradhSphTree<ndim,ParticleType>::UpdateAllSphProperties
     //=============================================================================================
 
     // Free-up all memory
+    delete[] r;
+    delete[] m2;
+    delete[] m;
+    delete[] drsqd2;
+    delete[] drsqd;
+    delete[] ptype;
     delete[] neiblist;
 
   }
@@ -266,6 +301,7 @@ void GradhSphTree<ndim,ParticleType>::UpdateAllSphProperties
 
   // Update tree smoothing length values here
   tree->UpdateAllHmaxValues(sphdata);
+  tree->UpdateNeighbourCache(sphdata, false);
 
   return;
 }
@@ -303,10 +339,26 @@ void GradhSphTree<ndim,ParticleType>::UpdateAllSphHydroForces
   // If there are no active cells, return to main loop
   if (cactive == 0) return;
 
+  // Each pair can only be computed once if all inactive neighbours have already been advanced,
+  // i.e. are on lower timestep levels than every active particle.  This is not the case when
+  // particles are re-activated mid-step by the timestep limiter, so the forces are then
+  // computed separately for each active particle instead.
+  bool pair_once = symmetric_forces;
+  if (pair_once) {
+    int levelactive   = 9999;
+    int levelinactive = -1;
+    for (int i=0; i<sph->Ntot; i++) {
+      if (sphdata[i].flags.is_dead()) continue;
+      if (sphdata[i].flags.check(active)) levelactive = min(levelactive, sphdata[i].level);
+      else levelinactive = max(levelinactive, sphdata[i].level);
+    }
+    pair_once = (levelinactive < levelactive);
+  }
+
 
   // Set-up all OMP threads
   //===============================================================================================
-#pragma omp parallel default(none) shared(cactive,celllist,nbody,simbox,sph,sphdata)
+#pragma omp parallel default(none) shared(cactive,celllist,nbody,pair_once,simbox,sph,sphdata)
   {
 #if defined _OPENMP
     const int ithread = omp_get_thread_num();
@@ -317,9 +369,26 @@ void GradhSphTree<ndim,ParticleType>::UpdateAllSphHydroForces
     int* levelneib    = levelneibbuf[ithread];     // ..
     ParticleType<ndim>* activepart = activepartbuf[ithread];   // ..
     NeighbourManager<ndim,HydroParticle>& neibmanager = neibmanagerbufhydro[ithread];
+    const bool do_pair_once = pair_once;
+    FLOAT (*aBuffer)[ndim] = 0;                    // Summed accelerations (symmetric forces)
+    FLOAT *dudtBuffer      = 0;                    // Summed heating rates (  "      "    )
+    FLOAT *div_vBuffer     = 0;                    // Summed div_v values  (  "      "    )
 
     for (int i=0; i<sph->Ntot; i++) levelneib[i] = 0;
 
+    // When computing each pair only once, the contributions to all particles are summed in
+    // local buffers for each thread and added to the main arrays at the end
+    if (do_pair_once) {
+      aBuffer     = new FLOAT[sph->Ntot][ndim];
+      dudtBuffer  = new FLOAT[sph->Ntot];
+      div_vBuffer = new FLOAT[sph->Ntot];
+      for (int i=0; i<sph->Ntot; i++) {
+        for (int k=0; k<ndim; k++) aBuffer[i][k] = (FLOAT) 0.0;
+        dudtBuffer[i]  = (FLOAT) 0.0;
+        div_vBuffer[i] = (FLOAT) 0.0;
+      }
+    }
+
 
     // Loop over all active cells
     //=============================================================================================
@@ -355,7 +424,6 @@ void GradhSphTree<ndim,ParticleType>::UpdateAllSphHydroForces
 
         if (do_hydro) {
           Typemask hydromask  = sph->types[activepart[j].ptype].hydromask;
-          const bool do_pair_once = false;
           NeighbourList<HydroParticle> neiblist =
               neibmanager.GetParticleNeib(activepart[j],hydromask,do_pair_once);
 
@@ -367,7 +435,8 @@ void GradhSphTree<ndim,ParticleType>::UpdateAllSphHydroForces
 
           // Compute all neighbour contributions to hydro forces
           typename ParticleType<ndim>::HydroMethod* method = (typename ParticleType<ndim>::HydroMethod*) sph;
-          method->ComputeSphHydroForces(activepart[j],neiblist);
+          if (do_pair_once) method->ComputeSymmetricSphHydroForces(activepart[j],neiblist);
+          else method->ComputeSphHydroForces(activepart[j],neiblist);
         }
       }
       //-------------------------------------------------------------------------------------------
@@ -379,6 +448,13 @@ void GradhSphTree<ndim,ParticleType>::UpdateAllSphHydroForces
         const int i=neighbour.first;
         HydroParticle& neibpart=*(neighbour.second);
         levelneib[i]=max(levelneib[i],neibpart.levelneib);
+
+        // Accumulate the neighbour's half of the pair-wise forces (active, non-mirror only)
+        if (do_pair_once && !neibpart.flags.is_mirror() && neibpart.flags.check(active)) {
+          for (int k=0; k<ndim; k++) aBuffer[i][k] += neibpart.a[k];
+          dudtBuffer[i]  += neibpart.dudt;
+          div_vBuffer[i] += neibpart.div_v;
+        }
       }
 
 
@@ -395,13 +471,20 @@ void GradhSphTree<ndim,ParticleType>::UpdateAllSphHydroForces
       // Add all active particles contributions to main array
       for (int j=0; j<Nactive; j++) {
         const int i = activelist[j];
-        for (int k=0; k<ndim; k++) sphdata[i].a[k]     += activepart[j].a[k];
+        if (do_pair_once) {
+          for (int k=0; k<ndim; k++) aBuffer[i][k] += activepart[j].a[k];
+          dudtBuffer[i]  += activepart[j].dudt;
+          div_vBuffer[i] += activepart[j].div_v;
+        }
+        else {
+          for (int k=0; k<ndim; k++) sphdata[i].a[k] += activepart[j].a[k];
+          sphdata[i].dudt     += activepart[j].dudt;
+          sphdata[i].dalphadt += activepart[j].dalphadt;
+          sphdata[i].div_v    += activepart[j].div_v;
+        }
         for (int k=0; k<ndim; k++) sphdata[i].a[k]     += activepart[j].atree[k];
         for (int k=0; k<ndim; k++) sphdata[i].atree[k] += activepart[j].atree[k];
         sphdata[i].gpot     += activepart[j].gpot;
-        sphdata[i].dudt     += activepart[j].dudt;
-        sphdata[i].dalphadt += activepart[j].dalphadt;
-        sphdata[i].div_v    += activepart[j].div_v;
         levelneib[i]        = max(levelneib[i], activepart[j].levelneib);
       }
 
@@ -409,6 +492,35 @@ void GradhSphTree<ndim,ParticleType>::UpdateAllSphHydroForces
     //=============================================================================================
 
 
+    // Add the summed pair-wise contributions from all threads to the main arrays, and once all
+    // threads are finished, normalise div_v and add the compressional heating terms
+    if (do_pair_once) {
+#pragma omp critical
+      {
+        for (int i=0; i<sph->Ntot; i++) {
+          if (sphdata[i].flags.check(active)) {
+            for (int k=0; k<ndim; k++) sphdata[i].a[k] += aBuffer[i][k];
+            sphdata[i].dudt  += dudtBuffer[i];
+            sphdata[i].div_v += div_vBuffer[i];
+          }
+        }
+      }
+
+      delete[] div_vBuffer;
+      delete[] dudtBuffer;
+      delete[] aBuffer;
+
+#pragma omp barrier
+      typename ParticleType<ndim>::HydroMethod* method = (typename ParticleType<ndim>::HydroMethod*) sph;
+#pragma omp for
+      for (int i=0; i<sph->Nhydro; i++) {
+        if (sphdata[i].flags.check(active) && sph->types[sphdata[i].ptype].hydro_forces) {
+          method->FinishSphHydroForces(sphdata[i]);
+        }
+      }
+    }
+
+
     // Propagate the changes in levelneib to the main array
 #pragma omp for
     for (int i=0; i<sph->Ntot; i++) {
@@ -468,6 +580,15 @@ void GradhSphTree<ndim,ParticleType>::UpdateAllSphForces
   // If there are no active cells, return to main loop
   if (cactive == 0) return;
 
+  // Compute the local expansions of all active cells with the dual-tree walk
+  if (multipole == "fmm") {
+    CodeTiming::BlockTimer fmmtimer = timing->StartNewTimer("FMM_EXPANSIONS");
+    tree->ComputeFmmExpansions();
+  }
+
+  // Compute the long-range (mesh) part of the periodic gravity for TreePM
+  if (simbox.PeriodicGravity && ewald->pm != NULL) ewald->pm->ComputeMeshField(sph, nbody);
+
 
   // Set-up all OMP threads
   //===============================================================================================
@@ -516,7 +637,8 @@ void GradhSphTree<ndim,ParticleType>::UpdateAllSphForces
 
       // Compute neighbour list for cell depending on physics options
       neibmanager.clear();
-      tree->ComputeGravityInteractionAndGhostList(cell, neibmanager);
+      if (multipole == "fmm") tree->ComputeFmmNearList(cell, neibmanager);
+      else tree->ComputeGravityInteractionAndGhostList(cell, neibmanager);
       neibmanager.EndSearchGravity(cell,sphdata);
 
       MultipoleMoment<ndim>* gravcell;
@@ -554,6 +676,14 @@ void GradhSphTree<ndim,ParticleType>::UpdateAllSphForces
             ComputeCellQuadrupoleForces(activepart[j].gpot, activepart[j].atree,
                                         activepart[j].r, Ngravcell, gravcell);
          }
+          else if (multipole == "octupole") {
+            ComputeCellMultipoleForces(3, activepart[j].gpot, activepart[j].atree,
+                                          activepart[j].r, Ngravcell, gravcell);
+          }
+          else if (multipole == "hexadecapole") {
+            ComputeCellMultipoleForces(4, activepart[j].gpot, activepart[j].atree,
+                                          activepart[j].r, Ngravcell, gravcell);
+          }
 
           // Add the periodic correction force for SPH and direct-sum neighbours
           if (simbox.PeriodicGravity) {
@@ -577,6 +707,12 @@ void GradhSphTree<ndim,ParticleType>::UpdateAllSphForces
               for (int k=0; k<ndim; k++) activepart[j].atree[k] += aperiodic[k];
               activepart[j].gpot += potperiodic;
             }
+
+            // Add the long-range force interpolated from the mesh for TreePM
+            if (ewald->pm != NULL) {
+              ewald->pm->InterpolateMeshForces(activepart[j].r, activepart[j].atree,
+                                               activepart[j].gpot);
+            }
           }
         }
 
@@ -591,6 +727,9 @@ void GradhSphTree<ndim,ParticleType>::UpdateAllSphForces
       else if (multipole == "fast_quadrupole") {
         ComputeFastQuadrupoleForces(Nactive, Ngravcell, gravcell, cell, activepart, sph->types);
       }
+      else if (multipole == "fmm") {
+        ComputeFmmForces(Nactive, tree->GetFmmExpansion(cell.id), activepart, sph->types);
+      }
 
       // Set gpot_hydro (RadWS) before sink contribution
       for (int j=0; j<Nactive; j++) {
@@ -606,6 +745,21 @@ void GradhSphTree<ndim,ParticleType>::UpdateAllSphForces
         }
       }
 
+      // For TreePM, the long-range part of the star forces comes from the mesh, so only keep the
+      // short-range part of the (direct) star forces
+      if (simbox.PeriodicGravity && ewald->pm != NULL) {
+        for (int j=0; j<Nactive; j++) {
+          if (activelist[j] >= sph->Nhydro) continue;
+          for (int s=0; s<nbody->Nnbody; s++) {
+            FLOAT draux[ndim];
+            for (int k=0; k<ndim; k++) draux[k] = nbody->nbodydata[s]->r[k] - activepart[j].r[k];
+            ewald->CalculatePeriodicCorrection(nbody->nbodydata[s]->m, draux, aperiodic, potperiodic);
+            for (int k=0; k<ndim; k++) activepart[j].atree[k] += aperiodic[k];
+            activepart[j].gpot += potperiodic;
+          }
+        }
+      }
+
       // Add all active particles contributions to main array
       for (int j=0; j<Nactive; j++) {
         int i = activelist[j];
@@ -0,0 +1,185 @@
+//=================================================================================================
+//  ChunkedSnapshot.h
+//  Contains classes for writing and reading snapshot files in the chunked binary format.  Each
+//  field (e.g. x, rho) is stored as a separate array divided into chunks of a fixed number of
+//  particles, each of which may be compressed independently.  The header points to an index of
+//  all fields and chunks, plus the bounding box of the particles in each chunk, so single fields
+//  or particles in a selected region can be read without reading the whole file.
+//
+//  This file is part of GANDALF :
+//  Graphical Astrophysics code for N-body Dynamics And Lagrangian Fluids
+//  https://github.com/gandalfcode/gandalf
+//  Contact : gandalfcode@gmail.com
+//
+//  Copyright (C) 2013  D. A. Hubber, G. Rosotti
+//
+//  GANDALF is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  GANDALF is distributed in the hope that it will be useful, but
+//  WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  General Public License (http://www.gnu.org/licenses) for more details.
+//=================================================================================================
+
+
+#ifndef _CHUNKED_SNAPSHOT_H_
+#define _CHUNKED_SNAPSHOT_H_
+
+
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "Precision.h"
+using namespace std;
+
+
+static const string chunked_tag("GANDALFCHUNKEDV1");
+static const int chunked_string_length = 20;
+static const int chunked_nheader = 20;
+static const int chunked_alignment = 16;
+
+
+// Particle species stored in chunked snapshots
+enum ChunkedSpecies {
+  chunked_hydro = 0,
+  chunked_star  = 1,
+  chunked_Nspecies = 2
+};
+
+// Data types of fields stored in chunked snapshots
+enum ChunkedDataType {
+  chunked_float = 0,                   // Floating point (of size given in header)
+  chunked_int   = 1                    // 32-bit integer
+};
+
+// Compression codecs used for chunks
+enum ChunkedCodec {
+  codec_none       = 0,                // Raw data
+  codec_shuffle_lz = 1                 // Byte-shuffle followed by built-in LZ compression
+};
+
+
+//=================================================================================================
+//  Struct ChunkedSnapshotField
+/// \brief  Index entry of one field (i.e. one array) in a chunked snapshot file.
+//=================================================================================================
+struct ChunkedSnapshotField
+{
+  string name;                         ///< Name of field (e.g. x, rho)
+  string unit;                         ///< Name of (output) unit of field
+  int species;                         ///< Particle species (chunked_hydro or chunked_star)
+  int datatype;                        ///< Data type (chunked_float or chunked_int)
+  vector<long> offset;                 ///< Position of each chunk in file
+  vector<int> nbytes;                  ///< Size of each (compressed) chunk in bytes
+  vector<int> codec;                   ///< Codec used for each chunk
+};
+
+
+int ChunkedCompress(const char *, int, int, int, char *);
+bool ChunkedDecompress(const char *, int, int, int, char *, int);
+
+
+
+//=================================================================================================
+//  Class ChunkedSnapshotWriter
+/// \brief   Writes snapshot files in the chunked binary format.
+/// \details Fields are written one at a time with WriteField, and the index of all fields and
+///          chunks, plus the chunk bounding boxes, are written at the end of the file by Close.
+///          All floating point data is written with the size of FLOAT.
+/// \author  D. A. Hubber, G. Rosotti
+/// \date    17/10/2026
+//=================================================================================================
+class ChunkedSnapshotWriter
+{
+ private:
+  ofstream outfile;                    ///< Output file stream
+  vector<ChunkedSnapshotField> fields; ///< Index of all fields written so far
+  vector<DOUBLE> bbox[chunked_Nspecies]; ///< Bounding boxes of all chunks of each species
+  vector<char> buffer;                 ///< Buffer for compressing chunks
+
+ public:
+  ChunkedSnapshotWriter(string, int, int, int);
+
+  bool Close(void);
+  void WriteField(string, string, int, const FLOAT *, int, int=-1);
+  void WriteField(string, string, int, const int *, int);
+  void WriteChunks(ChunkedSnapshotField &, const char *, int, int);
+
+  const int codec;                     ///< Codec used for compressing chunks
+  const int ndim;                      ///< No. of dimensions
+  const int Nchunk;                    ///< No. of particles per chunk
+  int idata[chunked_nheader];          ///< Integer header data (particle numbers)
+  long ilpdata[chunked_nheader];       ///< Long integer header data (step counters)
+  DOUBLE ddata[chunked_nheader];       ///< Double precision header data (times)
+
+};
+
+
+
+//=================================================================================================
+//  Class ChunkedSnapshotReader
+/// \brief   Reads snapshot files in the chunked binary format.
+/// \details Open reads the header, the index of all fields and the chunk bounding boxes.  Single
+///          chunks of any field can then be read (and decompressed) with ReadChunk.
+/// \author  D. A. Hubber, G. Rosotti
+/// \date    17/10/2026
+//=================================================================================================
+class ChunkedSnapshotReader
+{
+ private:
+  ifstream infile;                     ///< Input file stream
+  vector<char> buffer;                 ///< Buffer for compressed chunks
+
+ public:
+  bool Open(string);
+  void Close(void) {infile.close();}
+  int FindField(string, int) const;
+  int ChunkLength(int, int) const;
+  int Nchunks(int) const;
+  bool ChunkOverlapsBox(int, int, const DOUBLE *, const DOUBLE *) const;
+  void ReadChunk(int, int, vector<char> &);
+
+
+  //===============================================================================================
+  //  ChunkedSnapshotReader::ReadFieldChunk
+  /// Read one chunk of a field and convert it to the given type.
+  //===============================================================================================
+  template <class T>
+  int ReadFieldChunk
+   (int ifield,                        ///< [in] Index of field
+    int ichunk,                        ///< [in] Chunk number
+    T *values)                         ///< [out] Field values of all particles in chunk
+  {
+    const int N = ChunkLength(fields[ifield].species, ichunk);
+    ReadChunk(ifield, ichunk, raw);
+    if (fields[ifield].datatype == chunked_int) {
+      const int *data = reinterpret_cast<const int *>(&raw[0]);
+      for (int i=0; i<N; i++) values[i] = (T) data[i];
+    }
+    else if (precision == sizeof(double)) {
+      const double *data = reinterpret_cast<const double *>(&raw[0]);
+      for (int i=0; i<N; i++) values[i] = (T) data[i];
+    }
+    else {
+      const float *data = reinterpret_cast<const float *>(&raw[0]);
+      for (int i=0; i<N; i++) values[i] = (T) data[i];
+    }
+    return N;
+  }
+
+
+  int ndim;                            ///< No. of dimensions
+  int precision;                       ///< Size of floating point data in file
+  int idata[chunked_nheader];          ///< Integer header data (particle numbers)
+  long ilpdata[chunked_nheader];       ///< Long integer header data (step counters)
+  DOUBLE ddata[chunked_nheader];       ///< Double precision header data (times)
+  vector<ChunkedSnapshotField> fields; ///< Index of all fields in file
+  vector<DOUBLE> bbox[chunked_Nspecies]; ///< Bounding boxes of all chunks of each species
+  vector<char> raw;                    ///< Buffer for decompressed chunks
+
+};
+#endif
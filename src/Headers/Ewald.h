@@ -33,6 +33,7 @@
 #include "DomainBox.h"
 #include "Constants.h"
 #include "CodeTiming.h"
+#include "ParticleMesh.h"
 using namespace std;
 #ifdef GANDALF_GSL
 #include <gsl/gsl_sf.h>
@@ -55,6 +56,7 @@ class Ewald
   // Constructor and destructor
   //-----------------------------------------------------------------------------------------------
   Ewald(DomainBox<ndim> &, int, int, int, DOUBLE, DOUBLE, DOUBLE, DOUBLE, CodeTiming *);
+  Ewald(DomainBox<ndim> &, ParticleMesh<ndim> *, CodeTiming *);
   ~Ewald();
 
 
@@ -113,6 +115,7 @@ class Ewald
   const DOUBLE lz_per;
   const int nEwaldGrid;
 
+  ParticleMesh<ndim> *pm;               ///< Long-range mesh gravity for TreePM (or NULL for Ewald)
   CodeTiming* timing;
 
 };
@@ -28,6 +28,7 @@
 
 #include <assert.h>
 #include <string>
+#include <vector>
 #include "Debug.h"
 #include "Precision.h"
 #include "Constants.h"
@@ -94,6 +95,15 @@ public:
                                     const FLOAT*, const FLOAT*, SimulationBase*);
 
 
+  // Per-level index of particles for hierarchical block timesteps
+  //-----------------------------------------------------------------------------------------------
+  int FindEndOfStepParticles(const int, const int);
+  void UpdateLevelIndex(const int);
+  int MaxInactiveLevel(DOUBLE &);
+  void InvalidateLevelIndex(void) {levelindex_valid = false;}
+  bool UseEndOfStepList(const int n) const {return levelindex_valid && nendstep == n;}
+
+
   // Functions needed to hide some implementation details
   //-----------------------------------------------------------------------------------------------
   Particle<ndim>& GetParticlePointer(const int i) {
@@ -151,6 +161,15 @@ public:
   TabulatedKernel<ndim> kerntab;       ///< Tabulated version of chosen kernel
   ExternalPotential<ndim> *extpot;     ///< Pointer to external potential object
 
+
+  // Block timestep level index
+  //-----------------------------------------------------------------------------------------------
+  bool levelindex_valid;               ///< Is the per-level particle index up-to-date?
+  int level_sync;                      ///< Lowest timestep level synchronised at nendstep
+  int nendstep;                        ///< Integer time of the end-of-step list
+  vector<vector<int> > levelindex;     ///< I.d.s of all real particles on each timestep level
+  vector<int> endsteplist;             ///< I.d.s of all particles on synchronised levels
+
 };
 
 template<int ndim>
@@ -193,6 +212,7 @@ int Hydrodynamics<ndim>::DoDeleteDeadParticles() {
   Nmpighost       = 0;
   Nhydro         -= Ndead;
   Ntot            = Nhydro;
+  levelindex_valid = false;
 
   // Some sanity checking to ensure there are no dead particles remaining
   for (i=0; i<Nhydro; i++) {
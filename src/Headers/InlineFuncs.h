@@ -53,6 +53,23 @@ inline T DotProduct(T *v1, T *v2, int ndim)
     return v1[0]*v2[0] + v1[1]*v2[1] + v1[2]*v2[2];
 }
 
+//=================================================================================================
+//  DotProduct
+//  Dot product of two vectors of different precision (e.g. KFLOAT and FLOAT),
+//  evaluated and returned in FLOAT precision
+//=================================================================================================
+template <typename T1, typename T2>
+inline FLOAT DotProduct(T1 *v1, T2 *v2, int ndim)
+{
+  if (ndim == 1)
+    return (FLOAT) v1[0]*(FLOAT) v2[0];
+  else if (ndim == 2)
+    return (FLOAT) v1[0]*(FLOAT) v2[0] + (FLOAT) v1[1]*(FLOAT) v2[1];
+  else
+    return (FLOAT) v1[0]*(FLOAT) v2[0] + (FLOAT) v1[1]*(FLOAT) v2[1] +
+      (FLOAT) v1[2]*(FLOAT) v2[2];
+}
+
 //=================================================================================================
 //  Distance
 //  Calculates the distance product between two points, x1 and x2,
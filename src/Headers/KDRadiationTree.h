@@ -154,5 +154,7 @@ class KDRadiationTree
   int *inext;                          ///< Linked list for grid search
   CellType<ndim,nfreq> *radcell;       ///< Array of tree cells
 
+  static const int Ntaskmin = 4096;    ///< Min. no. of particles in cell for OpenMP tasks
+
 };
 #endif
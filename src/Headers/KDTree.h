@@ -53,6 +53,8 @@ struct KDTreeCell : public TreeCellBase<ndim> {
   int c2;                           ///< Second child cell
   int c2g;                          ///< i.d. of tree-cell c/grid-cell g
   int k_divide;                     ///< Dimension along which cell is split
+  FLOAT r_divide;                   ///< Position of division plane
+  FLOAT bbvol;                      ///< Volume of bounding box when cell was last divided
 
 #ifdef MPI_PARALLEL
   typedef TreeCommunicationHandler<ndim> HandlerType;
@@ -124,23 +126,38 @@ class KDTree : public Tree<ndim,ParticleType,TreeCell>
   void CreateTreeStructure(void);
   void DivideTreeCell(int, int, ParticleType<ndim> *, TreeCell<ndim> &);
   void ExtrapolateCellProperties(const FLOAT);
+  void RefitTree(Particle<ndim> *, const FLOAT);
+  void RefitTreeCell(ParticleType<ndim> *, TreeCell<ndim> &, const FLOAT);
   FLOAT QuickSelect(int, int, int, int, ParticleType<ndim> *);
+  FLOAT QuickSelectParallel(int, int, int, int, ParticleType<ndim> *);
   FLOAT QuickSelectSort(int, int, int, int, ParticleType<ndim> *);
   void StockTree(Particle<ndim> *part_gen, bool stock_leaf) {
     ParticleType<ndim>* partdata = reinterpret_cast<ParticleType<ndim>*>(part_gen) ;
-    StockTree(celldata[0], partdata, stock_leaf) ;
+#pragma omp parallel default(none) shared(partdata,stock_leaf)
+    {
+#pragma omp single
+      StockTree(celldata[0], partdata, stock_leaf) ;
+    }
   }
   void StockTree(TreeCell<ndim>&, ParticleType<ndim> *, bool);
   void StockCellProperties(TreeCell<ndim> &, ParticleType<ndim> *,bool);
   void UpdateAllHmaxValues(Particle<ndim> *part_gen) {
     ParticleType<ndim>* partdata = reinterpret_cast<ParticleType<ndim>*>(part_gen) ;
-    UpdateHmaxValues(celldata[0], partdata) ;
+#pragma omp parallel default(none) shared(partdata)
+    {
+#pragma omp single
+      UpdateHmaxValues(celldata[0], partdata) ;
+    }
   }
   void UpdateHmaxValues(TreeCell<ndim>&, ParticleType<ndim> *);
   void UpdateActiveParticleCounters(Particle<ndim> *);
 #ifdef MPI_PARALLEL
   void UpdateWorkCounters() {
-    UpdateWorkCounters(celldata[0]) ;
+#pragma omp parallel default(none)
+    {
+#pragma omp single
+      UpdateWorkCounters(celldata[0]) ;
+    }
   }
   void UpdateWorkCounters(TreeCell<ndim>&);
   int GetMaxCellNumber(const int _level) {return pow(2,_level+1)-1;};
@@ -149,5 +166,11 @@ class KDTree : public Tree<ndim,ParticleType,TreeCell>
   void ValidateTree(ParticleType<ndim> *);
 #endif
 
+
+  // Minimum no. of particles in a cell for building and stocking its children cells as separate
+  // OpenMP tasks, and for partitioning the cell with the parallel QuickSelect
+  //-----------------------------------------------------------------------------------------------
+  static const int Ntaskmin = 4096;
+
 };
 #endif
@@ -38,6 +38,7 @@
 #include "SmoothingKernel.h"
 #include "Particle.h"
 #include "MeshlessFV.h"
+#include "SpaceFillingCurve.h"
 #include "DomainBox.h"
 #include "Ewald.h"
 #include "Parameters.h"
@@ -94,6 +95,10 @@ protected:
 #endif
   virtual void SetTimingObject(CodeTiming*) = 0 ;
   virtual void ToggleNeighbourCheck(bool do_check) = 0 ;
+  virtual void SetParticleReordering(const int, const string) = 0;
+  virtual void SetNeighbourSkin(const FLOAT) = 0;
+  virtual void SetGravityCutoff(const FLOAT) = 0;
+  virtual void SetTreeRefit(const int, const FLOAT) = 0;
   virtual void UpdateTimestepsLimitsFromDistantParticles(Hydrodynamics<ndim>*,const bool) = 0 ;
 
   virtual MAC_Type GetOpeningCriterion() const = 0;
@@ -184,6 +189,16 @@ protected:
 #endif
   virtual void SetTimingObject(CodeTiming* timer) { timing = timer ; }
   virtual void ToggleNeighbourCheck(bool do_check) { neibcheck = do_check; }
+  virtual void SetParticleReordering(const int _nreorderstep, const string _sfc_curve) {
+    nreorderstep = _nreorderstep;
+    sfc_curve    = GetSfcType(_sfc_curve);
+  }
+  virtual void SetNeighbourSkin(const FLOAT _neibskin) {tree->SetNeighbourSkin(_neibskin);}
+  virtual void SetGravityCutoff(const FLOAT _rcutgrav) {tree->SetGravityCutoff(_rcutgrav);}
+  virtual void SetTreeRefit(const int _tree_refit, const FLOAT _refit_tol) {
+    tree_refit = _tree_refit;
+    refit_tol  = _refit_tol;
+  }
 
   virtual MAC_Type GetOpeningCriterion() const ;
   virtual void SetOpeningCriterion(const MAC_Type) ;
@@ -259,6 +274,7 @@ protected:
   //-----------------------------------------------------------------------------------------------
   void AllocateMemory(const int);
   void DeallocateMemory(void);
+  void ReorderParticles(Hydrodynamics<ndim> *);
 
 
 
@@ -280,6 +296,11 @@ protected:
   bool neibcheck;                      ///< Flag to verify neighbour lists
   FLOAT kernrange;                     ///< Kernel extent (in units of h)
   FLOAT kernrangesqd;                  ///< Kernel extent (squared)
+  int nreorderstep;                    ///< No. of tree re-builds between particle re-orderings
+  int Nrebuild;                        ///< No. of tree re-builds since start of simulation
+  SfcType sfc_curve;                   ///< Space-filling curve used for particle re-ordering
+  int tree_refit;                      ///< Refit tree incrementally on stock steps (0 = no)
+  FLOAT refit_tol;                     ///< Tolerance for re-dividing cells when refitting tree
 
 
   // Class variables
@@ -353,19 +374,20 @@ FLOAT rp[ndim],                      ///< [in] Position of point
 int Ngravcell,                       ///< [in] No. of tree cells in list
 MultipoleMoment<ndim> *gravcell)     ///< [in] List of tree cell ids
 {
-  FLOAT dr[ndim];                      // Relative position vector
+  KFLOAT dr[ndim];                     // Relative position vector
 
-  // Loop over all neighbouring particles in list
+  // Loop over all neighbouring particles in list.  The relative position is computed in FLOAT
+  // precision, the pair terms in KFLOAT and the sums are accumulated in FLOAT again.
   //-----------------------------------------------------------------------------------------------
   for (int cc=0; cc<Ngravcell; cc++) {
     MultipoleMoment<ndim>& cell = gravcell[cc];
 
-    FLOAT mc = cell.m;
-    for (int k=0; k<ndim; k++) dr[k] = cell.r[k] - rp[k];
-    FLOAT drsqd    = DotProduct(dr,dr,ndim) + small_number;
-    FLOAT invdrsqd = (FLOAT) 1.0/drsqd;
-    FLOAT invdrmag = sqrt(invdrsqd);
-    FLOAT invdr3   = invdrsqd*invdrmag;
+    KFLOAT mc = (KFLOAT) cell.m;
+    for (int k=0; k<ndim; k++) dr[k] = (KFLOAT) (cell.r[k] - rp[k]);
+    KFLOAT drsqd    = DotProduct(dr,dr,ndim) + (KFLOAT) small_number;
+    KFLOAT invdrsqd = (KFLOAT) 1.0/drsqd;
+    KFLOAT invdrmag = sqrt(invdrsqd);
+    KFLOAT invdr3   = invdrsqd*invdrmag;
 
     gpot += mc*invdrmag;
     for (int k=0; k<ndim; k++) agrav[k] += mc*dr[k]*invdr3;
@@ -449,6 +471,114 @@ inline void ComputeQuadropole(const MultipoleMoment<3>& cell, const FLOAT rp[3],
 }
 
 
+//=================================================================================================
+//  ComputeHigherMultipoles
+/// Add the octupole and (if order > 3) hexadecapole terms of a cell's multipole expansion to the
+/// acceleration and potential at position rp.  Uses the raw (packed) higher moments of the cell
+/// contracted with the Cartesian derivatives of 1/r, i.e. the (-1)^n/n! M^(n).D^(n)(1/r) terms
+/// of the Taylor series of the potential about the cell COM.
+//=================================================================================================
+template <int ndim>
+inline void ComputeHigherMultipoles
+ (const MultipoleMoment<ndim> &cell,   ///< [in] Multipole moments of cell
+  const FLOAT rp[ndim],                ///< [in] Position of point
+  const int order,                     ///< [in] Order of expansion (3 or 4)
+  FLOAT agrav[ndim],                   ///< [inout] Acceleration array
+  FLOAT &gpot)                         ///< [inout] Grav. potential
+{
+  int n = 0;                           // Packed tensor component counter
+  FLOAT dr[ndim];                      // Relative position vector
+  FLOAT mddd = (FLOAT) 0.0;            // M3.ddd
+  FLOAT mdd[ndim];                     // M3.dd (and later M4.ddd) vector
+  FLOAT tr[ndim];                      // Trace of M3 (vector)
+  FLOAT trdot = (FLOAT) 0.0;           // Trace vector dotted with dr
+  FLOAT w;                             // Component weighted by its multiplicity
+
+  for (int k=0; k<ndim; k++) dr[k] = rp[k] - cell.r[k];
+  const FLOAT drsqd    = DotProduct(dr,dr,ndim) + small_number;
+  const FLOAT invdrsqd = (FLOAT) 1.0/drsqd;
+  const FLOAT invdrmag = sqrt(invdrsqd);
+  const FLOAT g2 = (FLOAT) 3.0*invdrsqd*invdrsqd*invdrmag;
+  const FLOAT g3 = -(FLOAT) 5.0*g2*invdrsqd;
+  const FLOAT g4 = -(FLOAT) 7.0*g3*invdrsqd;
+
+  // Octupole term
+  for (int k=0; k<ndim; k++) mdd[k] = (FLOAT) 0.0;
+  for (int c=0; c<ndim; c++) {
+    for (int b=0; b<=c; b++) {
+      for (int a=0; a<=b; a++) {
+        w = cell.q3[n++]*((a == c) ? (FLOAT) 1.0 : ((a == b || b == c) ? (FLOAT) 3.0 : (FLOAT) 6.0));
+        mddd += w*dr[a]*dr[b]*dr[c];
+        w *= onethird;
+        mdd[a] += w*dr[b]*dr[c];
+        mdd[b] += w*dr[a]*dr[c];
+        mdd[c] += w*dr[a]*dr[b];
+      }
+    }
+  }
+  for (int k=0; k<ndim; k++) {
+    tr[k] = (FLOAT) 0.0;
+    for (int kk=0; kk<ndim; kk++) tr[k] += cell.q3[SymTensorIndex(k,kk,kk)];
+    trdot += tr[k]*dr[k];
+  }
+  gpot -= (g3*mddd + (FLOAT) 3.0*g2*trdot)/(FLOAT) 6.0;
+  for (int k=0; k<ndim; k++) {
+    agrav[k] -= (dr[k]*(g4*mddd + (FLOAT) 3.0*g3*trdot) +
+                 (FLOAT) 3.0*(g3*mdd[k] + g2*tr[k]))/(FLOAT) 6.0;
+  }
+  if (order < 4) return;
+
+  // Hexadecapole term
+  FLOAT mdddd = (FLOAT) 0.0;           // M4.dddd
+  FLOAT mt[ndim][ndim];                // Trace of M4 (matrix)
+  FLOAT mtd[ndim];                     // Trace matrix dotted with dr
+  FLOAT mtdd = (FLOAT) 0.0;            // dr.(trace matrix).dr
+  FLOAT mtt = (FLOAT) 0.0;             // Full trace of M4
+  const FLOAT g5 = -(FLOAT) 9.0*g4*invdrsqd;
+
+  n = 0;
+  for (int k=0; k<ndim; k++) mdd[k] = (FLOAT) 0.0;
+  for (int d=0; d<ndim; d++) {
+    for (int c=0; c<=d; c++) {
+      for (int b=0; b<=c; b++) {
+        for (int a=0; a<=b; a++) {
+          if (a == d) w = (FLOAT) 1.0;
+          else if (a == c || b == d) w = (FLOAT) 4.0;
+          else if (a == b && c == d) w = (FLOAT) 6.0;
+          else w = (FLOAT) 12.0;
+          w *= cell.q4[n++];
+          mdddd += w*dr[a]*dr[b]*dr[c]*dr[d];
+          w *= (FLOAT) 0.25;
+          mdd[a] += w*dr[b]*dr[c]*dr[d];
+          mdd[b] += w*dr[a]*dr[c]*dr[d];
+          mdd[c] += w*dr[a]*dr[b]*dr[d];
+          mdd[d] += w*dr[a]*dr[b]*dr[c];
+        }
+      }
+    }
+  }
+  for (int k=0; k<ndim; k++) {
+    for (int kk=0; kk<ndim; kk++) {
+      mt[k][kk] = (FLOAT) 0.0;
+      for (int j=0; j<ndim; j++) mt[k][kk] += cell.q4[SymTensorIndex(k,kk,j,j)];
+    }
+  }
+  for (int k=0; k<ndim; k++) {
+    mtd[k] = (FLOAT) 0.0;
+    for (int kk=0; kk<ndim; kk++) mtd[k] += mt[k][kk]*dr[kk];
+    mtdd += mtd[k]*dr[k];
+    mtt += mt[k][k];
+  }
+  gpot += (g4*mdddd + (FLOAT) 6.0*g3*mtdd + (FLOAT) 3.0*g2*mtt)/(FLOAT) 24.0;
+  for (int k=0; k<ndim; k++) {
+    agrav[k] += (dr[k]*(g5*mdddd + (FLOAT) 6.0*g4*mtdd + (FLOAT) 3.0*g3*mtt) +
+                 (FLOAT) 4.0*g4*mdd[k] + (FLOAT) 12.0*g3*mtd[k])/(FLOAT) 24.0;
+  }
+
+  return;
+}
+
+
 //=================================================================================================
 //  ComputeCellQuadrupoleForces
 /// Compute the force on particle 'parti' due to all cells obtained in the
@@ -474,6 +604,33 @@ void ComputeCellQuadrupoleForces
   return;
 }
 
+//=================================================================================================
+//  ComputeCellMultipoleForces
+/// Compute the force on particle 'parti' due to all cells obtained in the gravity tree walk
+/// including the quadrupole, octupole and (for order 4) hexadecapole moment terms.
+//=================================================================================================
+template <int ndim>
+void ComputeCellMultipoleForces
+ (const int order,                     ///< [in] Order of multipole expansion (3 or 4)
+  FLOAT &gpot,                         ///< [inout] Grav. potential
+  FLOAT agrav[ndim],                   ///< [inout] Acceleration array
+  FLOAT rp[ndim],                      ///< [in] Position of point
+  int Ngravcell,                       ///< [in] No. of tree cells in list
+  MultipoleMoment<ndim> *gravcell)     ///< [in] List of tree cell ids
+{
+
+  // Loop over all neighbouring particles in list
+  //-----------------------------------------------------------------------------------------------
+  for (int cc=0; cc<Ngravcell; cc++) {
+    ComputeQuadropole(gravcell[cc], rp, agrav, gpot) ;
+    ComputeHigherMultipoles(gravcell[cc], rp, order, agrav, gpot) ;
+  }
+  //-----------------------------------------------------------------------------------------------
+
+
+  return;
+}
+
 //=================================================================================================
 //  class FastMultipoleForces
 /// \brief Class for computing the gravitational forces using the fast monopole expansion
@@ -826,4 +983,23 @@ void ComputeFastQuadrupoleForces
   return;
 }
 
+//=================================================================================================
+//  ComputeFmmForces
+/// Compute the force on all active particles in a cell due to all distant cells from the local
+/// expansion of the cell computed by the dual-tree walk (i.e. the fmm multipole option).
+//=================================================================================================
+template <int ndim, template<int> class ParticleType>
+void ComputeFmmForces
+ (int Nactive,                         ///< [in] No. of active particles
+  const FmmLocalExpansion<ndim> &local, ///< [in] Local expansion of current cell
+  ParticleType<ndim> *activepart,      ///< [inout] Active Hydrodynamics particle array
+  const ParticleTypeRegister& types)   ///< [in] Flags specifying which particles need grav forces
+{
+  for (int j=0; j<Nactive; j++)
+    if (types[activepart[j].ptype].self_gravity)
+      local.Apply(activepart[j].r, activepart[j].atree, activepart[j].gpot);
+
+  return;
+}
+
 #endif
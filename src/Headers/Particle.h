@@ -313,7 +313,8 @@ struct GradhSphParticle : public SphParticle<ndim>
   class HydroForcesParticle {
   public:
 	  HydroForcesParticle(): ptype(gas_type), level(0), levelneib(0), iorig(0), flags(none), r(), v(), a(),
-	  m(0), rho (0), h(0), hrangesqd(0), hfactor(0), pressure(0), invomega(0), sound(0), u(0), alpha(0), zeta(0)
+	  m(0), rho (0), h(0), hrangesqd(0), hfactor(0), pressure(0), invomega(0), sound(0), u(0), alpha(0), zeta(0),
+	  dudt(0), div_v(0)
 	  {};
 
 	  HydroForcesParticle(const GradhSphParticle& p) {
@@ -325,7 +326,7 @@ struct GradhSphParticle : public SphParticle<ndim>
 		  for (int k=0; k<ndim; k++) {
 			  r[k]=p.r[k];
 			  v[k]=p.v[k];
-			  a[k]=p.a[k];
+			  a[k]=0;
 		  }
 		  m=p.m;
 		  rho=p.rho;
@@ -338,6 +339,8 @@ struct GradhSphParticle : public SphParticle<ndim>
 		  u=p.u;
 		  alpha=p.alpha;
           zeta=p.zeta;
+          dudt=0;
+          div_v=0;
 	  }
 
 	  int ptype;
@@ -359,6 +362,8 @@ struct GradhSphParticle : public SphParticle<ndim>
 	  FLOAT u;
 	  FLOAT alpha;
       FLOAT zeta;
+      FLOAT dudt;                      // Accumulators for the neighbour's half of symmetric
+      FLOAT div_v;                     // pair-wise forces (together with a)
 	  static const int NDIM=ndim;
 
   };
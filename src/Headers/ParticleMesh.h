@@ -0,0 +1,111 @@
+//=================================================================================================
+//  ParticleMesh.h
+//  Contains class definition for computing the long-range part of periodic gravity on a mesh
+//  (TreePM method).
+//
+//  This file is part of GANDALF :
+//  Graphical Astrophysics code for N-body Dynamics And Lagrangian Fluids
+//  https://github.com/gandalfcode/gandalf
+//  Contact : gandalfcode@gmail.com
+//
+//  Copyright (C) 2013  D. A. Hubber, G. Rosotti
+//
+//  GANDALF is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  GANDALF is distributed in the hope that it will be useful, but
+//  WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  General Public License (http://www.gnu.org/licenses) for more details.
+//=================================================================================================
+
+
+#ifndef _PARTICLE_MESH_H_
+#define _PARTICLE_MESH_H_
+
+
+#include <complex>
+#include <string>
+#include <vector>
+#include "Precision.h"
+#include "DomainBox.h"
+#include "Constants.h"
+#include "CodeTiming.h"
+#if defined(FFTW_TURBULENCE)
+#include "fftw3.h"
+#endif
+using namespace std;
+
+template <int ndim> class Hydrodynamics;
+template <int ndim> class Nbody;
+
+
+
+//=================================================================================================
+//  Class ParticleMesh
+/// \brief   Long-range periodic gravity computed on a mesh for the TreePM method.
+/// \details The gravitational potential is split into a short-range part, m*erfc(r/2rs)/r,
+///          which is computed by the tree (truncated at the cut-off radius rcut) and a long-range
+///          part, m*erf(r/2rs)/r, which is computed for the whole periodic box on a mesh.  The
+///          mass of all particles is assigned to the mesh (CIC or TSC), the Poisson equation is
+///          solved with FFTs and the accelerations and potential are interpolated back to the
+///          particle positions with the same assignment scheme.  Uses the FFTW library if
+///          compiled with FFTW = 1, otherwise an internal radix-2 FFT (requiring the no. of
+///          mesh cells to be a power of two).
+/// \author  D. A. Hubber, G. Rosotti
+/// \date    17/10/2026
+//=================================================================================================
+template <int ndim>
+class ParticleMesh
+{
+ public:
+
+  // Constructor and destructor
+  //-----------------------------------------------------------------------------------------------
+  ParticleMesh(const DomainBox<ndim> &, int, string, FLOAT, FLOAT, CodeTiming *);
+  ~ParticleMesh();
+
+
+  // Other functions
+  //-----------------------------------------------------------------------------------------------
+  void ComputeMeshField(Hydrodynamics<ndim> *, Nbody<ndim> *);
+  void InterpolateMeshForces(const FLOAT *, FLOAT *, FLOAT &) const;
+  void CalculateShortRangeCorrection(FLOAT, FLOAT *, FLOAT *, FLOAT &) const;
+
+
+ private:
+
+  void AssignMass(const FLOAT *, const FLOAT);
+  int ComputeStencil(const FLOAT *, int *, DOUBLE *) const;
+  void SolveMeshField(void);
+  void TransformMesh(const int);
+  static void TransformLine(complex<DOUBLE> *, const int, const int);
+
+
+  // ParticleMesh class variables
+  //-----------------------------------------------------------------------------------------------
+  const DomainBox<ndim> &simbox;       ///< Reference to simulation domain box
+  const int Ngrid;                     ///< No. of mesh cells per dimension
+  int Nmesh;                           ///< Total no. of mesh cells
+  int order;                           ///< Order of assignment scheme (2 = CIC, 3 = TSC)
+  DOUBLE dxmesh[ndim];                 ///< Size of mesh cells
+  vector<DOUBLE> rho;                  ///< Mesh density
+  vector<DOUBLE> meshpot;              ///< Long-range potential on mesh
+  vector<DOUBLE> meshacc[ndim];        ///< Long-range acceleration on mesh
+  vector<complex<DOUBLE> > phik;       ///< Fourier transform of long-range potential
+  vector<complex<DOUBLE> > work;       ///< Work array for FFTs
+#if defined(FFTW_TURBULENCE)
+  fftw_plan forward_plan;              ///< FFTW plan for forward transform of work array
+  fftw_plan backward_plan;             ///< FFTW plan for backward transform of work array
+#endif
+  CodeTiming *timing;                  ///< Pointer to code timing object
+
+ public:
+
+  FLOAT rsplit;                        ///< Force-split scale (rs) between tree and mesh
+  FLOAT rcut;                          ///< Cut-off radius of the short-range (tree) force
+
+};
+#endif
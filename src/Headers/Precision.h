@@ -33,20 +33,29 @@
 #if defined(GANDALF_SINGLE_PRECISION)
 #define GANDALF_MPI_FLOAT MPI_FLOAT
 #define GANDALF_MPI_DOUBLE MPI_DOUBLE
-#elif defined(GANDALF_DOUBLE_PRECISION)
+#elif defined(GANDALF_DOUBLE_PRECISION) || defined(GANDALF_MIXED_PRECISION)
 #define GANDALF_MPI_FLOAT MPI_DOUBLE
 #define GANDALF_MPI_DOUBLE MPI_DOUBLE
 #endif
 #endif
 
-// Floating point data types
+// Floating point data types.  KFLOAT is used for the relative positions and kernel evaluations
+// in the innermost pair loops (gravity cell forces, SPH hydro forces, meshless gradients).  In
+// the mixed precision build these run in single precision, while positions, accumulators and
+// the integrators (FLOAT) stay in double precision.
 //-----------------------------------------------------------------------------
 #if defined(GANDALF_SINGLE_PRECISION)
 typedef float FLOAT;
 typedef double DOUBLE;
+typedef float KFLOAT;
 #elif defined(GANDALF_DOUBLE_PRECISION)
 typedef double FLOAT;
 typedef double DOUBLE;
+typedef double KFLOAT;
+#elif defined(GANDALF_MIXED_PRECISION)
+typedef double FLOAT;
+typedef double DOUBLE;
+typedef float KFLOAT;
 #endif
 
 #if defined(GANDALF_SNAPSHOT_SINGLE_PRECISION)
@@ -78,6 +78,20 @@ template <int ndim>
 class Ic;
 
 
+//=================================================================================================
+//  Struct SnapshotWriter
+/// \brief  Background process writing a snapshot file when using asynchronous output.
+//=================================================================================================
+struct SnapshotWriter
+{
+  int pid;                             ///< Process id of background writer
+  string filename;                     ///< Name of snapshot file being written
+  string fileform;                     ///< Format of snapshot file
+  string restartlog;                   ///< Restart log to update once written ("" = none)
+};
+
+
+
 //=================================================================================================
 //  Class SimulationBase
 /// \brief  Creates a simulation object depending on the dimensionality.
@@ -103,8 +117,12 @@ class SimulationBase
   virtual bool ReadSerenUnformSnapshotFile(string)=0;
   virtual bool WriteSerenUnformSnapshotFile(string)=0;
   virtual bool WriteSerenLiteSnapshotFile(string)=0;
+  virtual void ReadChunkedHeaderFile(string, HeaderInfo& info)=0;
+  virtual bool ReadChunkedSnapshotFile(string)=0;
+  virtual bool WriteChunkedSnapshotFile(string)=0;
 
   std::list<string> keys;
+  std::list<SnapshotWriter> snapwriters;   ///< Queue of background snapshot writers
 
  public:
 
@@ -153,6 +171,10 @@ class SimulationBase
   //-----------------------------------------------------------------------------------------------
   bool ReadSnapshotFile(string,string);
   bool WriteSnapshotFile(string,string);
+  bool OutputSnapshotFile(string,string,string="");
+  bool WaitForSnapshotWriter(bool);
+  void FlushSnapshotWriters(void);
+  void WriteRestartLog(string,string,string);
   HeaderInfo ReadHeaderSnapshotFile(string filename, string format);
 
 
@@ -169,6 +191,7 @@ class SimulationBase
   bool rescale_particle_data;          ///< Flag to scale data to code units
   bool restart;                        ///< Flag to restart from last snapshot
   bool setup;                          ///< Flag if simulation is setup
+  int async_output;                    ///< Write snapshots in background processes
   int integration_step;                ///< Steps per complete integration step
   int litesnap;                        ///< Activate lite snapshots (for movies)
   int nbody_single_timestep;           ///< Flag if stars use same timestep
@@ -177,6 +200,7 @@ class SimulationBase
   int Nmpi;                            ///< No. of MPI processes
   int Noutsnap;                        ///< No. of output snapshots
   int Noutlitesnap;                    ///< No. of lite output snapshots
+  int Noutputqueue;                    ///< Max. no. of snapshots written in background at once
   int Nthreads;                        ///< Max no. of (OpenMP) threads
   int pruning_level_min;               ///< Min. level of pruned trees for MPI
   int pruning_level_max;               ///< Max. level of pruned trees for MPI
@@ -294,6 +318,9 @@ class Simulation : public SimulationBase
   virtual bool ReadSerenUnformSnapshotFile(string);
   virtual bool WriteSerenUnformSnapshotFile(string);
   virtual bool WriteSerenLiteSnapshotFile(string);
+  virtual void ReadChunkedHeaderFile(string, HeaderInfo& info);
+  virtual bool ReadChunkedSnapshotFile(string);
+  virtual bool WriteChunkedSnapshotFile(string);
   virtual void ConvertToCodeUnits(void);
 
 
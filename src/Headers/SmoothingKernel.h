@@ -120,6 +120,20 @@ public:
   FLOAT wzeta(const FLOAT);
   FLOAT wgrav(const FLOAT);
   FLOAT wpot(const FLOAT);
+
+  // Squared-distance versions.  The calls are explicitly qualified so that they are bound at
+  // compile-time and can be inlined when the kernel is used as a template parameter.
+  //---------------------------------------------------------------------------
+  FLOAT w0_s2(const FLOAT s) {return M4Kernel<ndim>::w0(sqrt(s));};
+  FLOAT womega_s2(const FLOAT s) {return M4Kernel<ndim>::womega(sqrt(s));};
+  FLOAT wzeta_s2(const FLOAT s) {return M4Kernel<ndim>::wzeta(sqrt(s));};
+
+#if defined(GANDALF_MIXED_PRECISION)
+  // Single-precision versions for the pair loops of the mixed precision build
+  //---------------------------------------------------------------------------
+  KFLOAT w0_s2(const KFLOAT);
+  KFLOAT w1(const KFLOAT);
+#endif
 };
 
 
@@ -157,6 +171,42 @@ inline FLOAT M4Kernel<ndim>::w1(const FLOAT s)  ///< [in] Kernel parameter, r/h
 }
 
 
+#if defined(GANDALF_MIXED_PRECISION)
+//=================================================================================================
+//  M4Kernel<ndim>::w0_s2
+/// Single-precision M4 kernel function of the squared kernel parameter, $W(s^2)$.
+//=================================================================================================
+template <int ndim>
+inline KFLOAT M4Kernel<ndim>::w0_s2(const KFLOAT ssqd)  ///< [in] Kernel parameter squared
+{
+  const KFLOAT s = sqrt(ssqd);
+  if (s < (KFLOAT) 1.0)
+    return (KFLOAT) kernnorm*((KFLOAT) 1.0 - (KFLOAT) 1.5*ssqd + (KFLOAT) 0.75*ssqd*s);
+  else if (s < (KFLOAT) 2.0)
+    return (KFLOAT) 0.25*(KFLOAT) kernnorm*((KFLOAT) 2.0 - s)*((KFLOAT) 2.0 - s)*((KFLOAT) 2.0 - s);
+  else
+    return (KFLOAT) 0.0;
+}
+
+
+
+//=================================================================================================
+//  M4Kernel<ndim>::w1
+/// Single-precision first spatial derivative of M4 kernel, dWdr.
+//=================================================================================================
+template <int ndim>
+inline KFLOAT M4Kernel<ndim>::w1(const KFLOAT s)  ///< [in] Kernel parameter, r/h
+{
+  if (s < (KFLOAT) 1.0)
+    return (KFLOAT) kernnorm*(-(KFLOAT) 3.0*s + (KFLOAT) 2.25*s*s);
+  else if (s < (KFLOAT) 2.0)
+    return -(KFLOAT) 0.75*(KFLOAT) kernnorm*((KFLOAT) 2.0 - s)*((KFLOAT) 2.0 - s);
+  else
+    return (KFLOAT) 0.0;
+}
+#endif
+
+
 
 //=================================================================================================
 //  M4Kernel<ndim>::womega
@@ -270,6 +320,20 @@ public:
   FLOAT wgrav(const FLOAT);
   FLOAT wpot(const FLOAT);
 
+  // Squared-distance versions.  The calls are explicitly qualified so that they are bound at
+  // compile-time and can be inlined when the kernel is used as a template parameter.
+  //---------------------------------------------------------------------------
+  FLOAT w0_s2(const FLOAT s) {return QuinticKernel<ndim>::w0(sqrt(s));};
+  FLOAT womega_s2(const FLOAT s) {return QuinticKernel<ndim>::womega(sqrt(s));};
+  FLOAT wzeta_s2(const FLOAT s) {return QuinticKernel<ndim>::wzeta(sqrt(s));};
+
+#if defined(GANDALF_MIXED_PRECISION)
+  // Single-precision versions for the pair loops of the mixed precision build
+  //---------------------------------------------------------------------------
+  KFLOAT w0_s2(const KFLOAT);
+  KFLOAT w1(const KFLOAT);
+#endif
+
 };
 
 
@@ -313,6 +377,57 @@ inline FLOAT QuinticKernel<ndim>::w1(const FLOAT s)
 }
 
 
+#if defined(GANDALF_MIXED_PRECISION)
+//=================================================================================================
+//  QuinticKernel<ndim>::w0_s2
+/// Single-precision quintic kernel function of the squared kernel parameter, $W(s^2)$.
+//=================================================================================================
+template <int ndim>
+inline KFLOAT QuinticKernel<ndim>::w0_s2(const KFLOAT ssqd)
+{
+  const KFLOAT s  = sqrt(ssqd);
+  const KFLOAT s3 = ssqd*s;
+  const KFLOAT s4 = ssqd*ssqd;
+  const KFLOAT s5 = s4*s;
+  if (s < (KFLOAT) 1.0)
+    return (KFLOAT) kernnorm*((KFLOAT) 66.0 - (KFLOAT) 60.0*ssqd + (KFLOAT) 30.0*s4 -
+                              (KFLOAT) 10.0*s5);
+  else if (s < (KFLOAT) 2.0)
+    return (KFLOAT) kernnorm*((KFLOAT) 51.0 + (KFLOAT) 75.0*s - (KFLOAT) 210.0*ssqd +
+                              (KFLOAT) 150.0*s3 - (KFLOAT) 45.0*s4 + (KFLOAT) 5.0*s5);
+  else if (s < (KFLOAT) 3.0)
+    return (KFLOAT) kernnorm*((KFLOAT) 243.0 - (KFLOAT) 405.0*s + (KFLOAT) 270.0*ssqd -
+                              (KFLOAT) 90.0*s3 + (KFLOAT) 15.0*s4 - s5);
+  else
+    return (KFLOAT) 0.0;
+}
+
+
+
+//=================================================================================================
+//  QuinticKernel<ndim>::w1
+/// Single-precision first spatial derivative of quintic kernel, dWdr.
+//=================================================================================================
+template <int ndim>
+inline KFLOAT QuinticKernel<ndim>::w1(const KFLOAT s)
+{
+  const KFLOAT ssqd = s*s;
+  const KFLOAT s3   = ssqd*s;
+  const KFLOAT s4   = ssqd*ssqd;
+  if (s < (KFLOAT) 1.0)
+    return (KFLOAT) kernnorm*(-(KFLOAT) 120.0*s + (KFLOAT) 120.0*s3 - (KFLOAT) 50.0*s4);
+  else if (s < (KFLOAT) 2.0)
+    return (KFLOAT) kernnorm*((KFLOAT) 75.0 - (KFLOAT) 420.0*s + (KFLOAT) 450.0*ssqd -
+                              (KFLOAT) 180.0*s3 + (KFLOAT) 25.0*s4);
+  else if (s < (KFLOAT) 3.0)
+    return (KFLOAT) kernnorm*(-(KFLOAT) 405.0 + (KFLOAT) 540.0*s - (KFLOAT) 270.0*ssqd +
+                              (KFLOAT) 60.0*s3 - (KFLOAT) 5.0*s4);
+  else
+    return (KFLOAT) 0.0;
+}
+#endif
+
+
 
 //=================================================================================================
 //  QuinticKernel<ndim>::womega
@@ -440,6 +555,20 @@ public:
   FLOAT wgrav(const FLOAT);
   FLOAT wpot(const FLOAT);
 
+  // Squared-distance versions.  The calls are explicitly qualified so that they are bound at
+  // compile-time and can be inlined when the kernel is used as a template parameter.
+  //---------------------------------------------------------------------------
+  FLOAT w0_s2(const FLOAT s) {return GaussianKernel<ndim>::w0(sqrt(s));};
+  FLOAT womega_s2(const FLOAT s) {return GaussianKernel<ndim>::womega(sqrt(s));};
+  FLOAT wzeta_s2(const FLOAT s) {return GaussianKernel<ndim>::wzeta(sqrt(s));};
+
+#if defined(GANDALF_MIXED_PRECISION)
+  // Single-precision versions for the pair loops of the mixed precision build
+  //---------------------------------------------------------------------------
+  KFLOAT w0_s2(const KFLOAT);
+  KFLOAT w1(const KFLOAT);
+#endif
+
 };
 
 
@@ -473,6 +602,37 @@ inline FLOAT GaussianKernel<ndim>::w1(const FLOAT s)
 }
 
 
+#if defined(GANDALF_MIXED_PRECISION)
+//=================================================================================================
+//  GaussianKernel<ndim>::w0_s2
+/// Single-precision Gaussian kernel function of the squared kernel parameter, $W(s^2)$.
+//=================================================================================================
+template <int ndim>
+inline KFLOAT GaussianKernel<ndim>::w0_s2(const KFLOAT ssqd)
+{
+  if (ssqd < (KFLOAT) kernrangesqd)
+    return (KFLOAT) kernnorm*exp(-ssqd);
+  else
+    return (KFLOAT) 0.0;
+}
+
+
+
+//=================================================================================================
+//  GaussianKernel<ndim>::w1
+/// Single-precision first spatial derivative of Gaussian kernel, dWdr.
+//=================================================================================================
+template <int ndim>
+inline KFLOAT GaussianKernel<ndim>::w1(const KFLOAT s)
+{
+  if (s < (KFLOAT) kernrange)
+    return -(KFLOAT) 2.0*(KFLOAT) kernnorm*s*exp(-s*s);
+  else
+    return (KFLOAT) 0.0;
+}
+#endif
+
+
 
 //=================================================================================================
 //  GaussianKernel<ndim>::womega
@@ -694,6 +854,13 @@ public:
   FLOAT wdrag(const FLOAT s);
   FLOAT wLOS(const FLOAT s);
 
+#if defined(GANDALF_MIXED_PRECISION)
+  // Single-precision versions for the pair loops of the mixed precision build
+  //---------------------------------------------------------------------------
+  KFLOAT w0_s2(const KFLOAT);
+  KFLOAT w1(const KFLOAT);
+#endif
+
 };
 
 
@@ -715,6 +882,18 @@ inline FLOAT TabulatedKernel<ndim>::w1 (const FLOAT s) {
   return tableLookup(tableW1, s);
 }
 
+#if defined(GANDALF_MIXED_PRECISION)
+template <int ndim>
+inline KFLOAT TabulatedKernel<ndim>::w0_s2 (const KFLOAT s2) {
+  return (KFLOAT) tableLookupSqd(tableW0_s2, (FLOAT) s2);
+}
+
+template <int ndim>
+inline KFLOAT TabulatedKernel<ndim>::w1 (const KFLOAT s) {
+  return (KFLOAT) tableLookup(tableW1, (FLOAT) s);
+}
+#endif
+
 template <int ndim>
 inline FLOAT TabulatedKernel<ndim>::womega (const FLOAT s) {
   return tableLookup(tableWomega, s);
@@ -0,0 +1,192 @@
+//=================================================================================================
+//  SpaceFillingCurve.h
+//  Contains inlined functions for computing Morton (Z-order) and Peano-Hilbert keys of points
+//  in 1, 2 or 3 dimensions.  Used to reorder the particle arrays in memory so that particles
+//  which are close in space are also close in memory.
+//
+//  This file is part of GANDALF :
+//  Graphical Astrophysics code for N-body Dynamics And Lagrangian Fluids
+//  https://github.com/gandalfcode/gandalf
+//  Contact : gandalfcode@gmail.com
+//
+//  Copyright (C) 2013  D. A. Hubber, G. Rosotti
+//
+//  GANDALF is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  GANDALF is distributed in the hope that it will be useful, but
+//  WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  General Public License (http://www.gnu.org/licenses) for more details.
+//=================================================================================================
+
+
+#ifndef _SPACE_FILLING_CURVE_H_
+#define _SPACE_FILLING_CURVE_H_
+
+
+#include <string>
+#include "Precision.h"
+#include "Exception.h"
+using namespace std;
+
+
+typedef unsigned long long sfckey_t;
+
+
+enum SfcType {
+  morton  = 0,
+  hilbert = 1
+};
+
+
+//=================================================================================================
+//  SfcBitsPerDim
+/// Returns the number of bits per dimension used to quantise positions so that the complete
+/// key fits into a single 64-bit integer.
+//=================================================================================================
+template <int ndim>
+inline int SfcBitsPerDim(void)
+{
+  return (ndim == 1) ? 32 : ((ndim == 2) ? 31 : 21);
+}
+
+
+
+//=================================================================================================
+//  SfcQuantisePosition
+/// Map the position 'r' onto the integer grid covering the box [rmin, rmin + 1/invlength] with
+/// 2^SfcBitsPerDim cells per side.
+//=================================================================================================
+template <int ndim>
+inline void SfcQuantisePosition
+ (const FLOAT *r,                      ///< [in] Position of point
+  const FLOAT *rmin,                   ///< [in] Minimum extent of bounding box
+  const FLOAT invlength,               ///< [in] 1 / (maximum side-length of bounding box)
+  unsigned int *x)                     ///< [out] Integer coordinates
+{
+  const sfckey_t nmax = ((sfckey_t) 1 << SfcBitsPerDim<ndim>()) - 1;
+  for (int k=0; k<ndim; k++) {
+    FLOAT s = (r[k] - rmin[k])*invlength;
+    if (s < (FLOAT) 0.0) s = (FLOAT) 0.0;
+    sfckey_t xk = (sfckey_t) (s*(FLOAT) nmax);
+    x[k] = (unsigned int) (xk > nmax ? nmax : xk);
+  }
+  return;
+}
+
+
+
+//=================================================================================================
+//  SfcInterleaveBits
+/// Interleave the bits of the integer coordinates, most-significant bit first, x[0] taking the
+/// highest bit at each level.
+//=================================================================================================
+template <int ndim>
+inline sfckey_t SfcInterleaveBits(const unsigned int *x)
+{
+  sfckey_t key = 0;
+  for (int b=SfcBitsPerDim<ndim>()-1; b>=0; b--) {
+    for (int k=0; k<ndim; k++) {
+      key = (key << 1) | (sfckey_t) ((x[k] >> b) & 1u);
+    }
+  }
+  return key;
+}
+
+
+
+//=================================================================================================
+//  MortonKey
+/// Compute the Morton (Z-order) key of the integer coordinates 'x'.
+//=================================================================================================
+template <int ndim>
+inline sfckey_t MortonKey(const unsigned int *x)
+{
+  return SfcInterleaveBits<ndim>(x);
+}
+
+
+
+//=================================================================================================
+//  HilbertKey
+/// Compute the Peano-Hilbert key of the integer coordinates 'x' using the transpose algorithm
+/// of Skilling (2004, AIP Conf. Proc. 707, 381).  The coordinates are first converted into the
+/// 'transposed' Hilbert index in place, and the bits are then interleaved to give the key.
+//=================================================================================================
+template <int ndim>
+inline sfckey_t HilbertKey(const unsigned int *xin)
+{
+  const int nbits = SfcBitsPerDim<ndim>();
+  const unsigned int M = 1u << (nbits - 1);
+  unsigned int x[ndim];
+  unsigned int P, Q, t;
+
+  if (ndim == 1) return SfcInterleaveBits<ndim>(xin);
+  for (int k=0; k<ndim; k++) x[k] = xin[k];
+
+  // Inverse undo of the excess work
+  for (Q=M; Q>1; Q>>=1) {
+    P = Q - 1;
+    for (int k=0; k<ndim; k++) {
+      if (x[k] & Q) {
+        x[0] ^= P;
+      }
+      else {
+        t = (x[0] ^ x[k]) & P;
+        x[0] ^= t;
+        x[k] ^= t;
+      }
+    }
+  }
+
+  // Gray encode
+  for (int k=1; k<ndim; k++) x[k] ^= x[k-1];
+  t = 0;
+  for (Q=M; Q>1; Q>>=1) {
+    if (x[ndim-1] & Q) t ^= Q - 1;
+  }
+  for (int k=0; k<ndim; k++) x[k] ^= t;
+
+  return SfcInterleaveBits<ndim>(x);
+}
+
+
+
+//=================================================================================================
+//  ComputeSfcKey
+/// Compute the space-filling curve key of the position 'r' for the selected curve type.
+//=================================================================================================
+template <int ndim>
+inline sfckey_t ComputeSfcKey
+ (const SfcType curve,                 ///< [in] Type of space-filling curve
+  const FLOAT *r,                      ///< [in] Position of point
+  const FLOAT *rmin,                   ///< [in] Minimum extent of bounding box
+  const FLOAT invlength)               ///< [in] 1 / (maximum side-length of bounding box)
+{
+  unsigned int x[ndim];
+  SfcQuantisePosition<ndim>(r, rmin, invlength, x);
+  if (curve == hilbert) return HilbertKey<ndim>(x);
+  else return MortonKey<ndim>(x);
+}
+
+
+
+//=================================================================================================
+//  GetSfcType
+/// Convert the parameter string into the space-filling curve type.
+//=================================================================================================
+inline SfcType GetSfcType(const string curve)
+{
+  if (curve == "morton") {
+    return morton;
+  }
+  else if (curve != "hilbert") {
+    ExceptionHandler::getIstance().raise("Unrecognised parameter : sfc_curve = " + curve);
+  }
+  return hilbert;
+}
+
+#endif
@@ -114,8 +114,8 @@ class Sph : public Hydrodynamics<ndim>
   // SPH functions for computing SPH sums with neighbouring particles
   // (fully coded in each separate SPH implementation, and not in Sph.cpp)
   //-----------------------------------------------------------------------------------------------
-  virtual int ComputeH(SphParticle<ndim> &, FLOAT, const vector<DensityParticle> &,
-                       Nbody<ndim> *) = 0;
+  virtual int ComputeH(SphParticle<ndim> &, const FLOAT, const int, const FLOAT *,
+                       const FLOAT *, const vector<DensityParticle> &, Nbody<ndim> *) = 0;
   virtual void ComputeThermalProperties(SphParticle<ndim> &) = 0;
   virtual void ComputeStarGravForces(const int, NbodyParticle<ndim> **, SphParticle<ndim> &) = 0;
 
@@ -183,6 +183,9 @@ public:
   virtual void ComputeSphGravForces(GradhSphParticle<ndim>&, NeighbourList<HydroNeib>&) = 0;
   virtual void ComputeSphHydroGravForces(GradhSphParticle<ndim>&, NeighbourList<HydroNeib>&) = 0;
   virtual void ComputeSphHydroForces(GradhSphParticle<ndim>&, NeighbourList<HydroNeib>&) = 0;
+  virtual void ComputeSymmetricSphHydroForces(GradhSphParticle<ndim>&,
+                                              NeighbourList<HydroNeib>&) = 0;
+  virtual void FinishSphHydroForces(GradhSphParticle<ndim>&) = 0;
   void ComputeDirectGravForces(GradhSphParticle<ndim>&, NeighbourList<DirectNeib>&) ;
 
 
@@ -246,11 +249,14 @@ public:
     return this->template DoDeleteDeadParticles<GradhSphParticle>() ;
   }
 
-  virtual int ComputeH(SphParticle<ndim> &, FLOAT, const vector<DensityParticle> &, Nbody<ndim> *);
+  virtual int ComputeH(SphParticle<ndim> &, const FLOAT, const int, const FLOAT *,
+                       const FLOAT *, const vector<DensityParticle> &, Nbody<ndim> *);
   void ComputeThermalProperties(SphParticle<ndim> &);
   virtual void ComputeSphGravForces(GradhSphParticle<ndim>&, NeighbourList<HydroNeib>&);
   virtual void ComputeSphHydroGravForces(GradhSphParticle<ndim>&, NeighbourList<HydroNeib>&);
   virtual void ComputeSphHydroForces(GradhSphParticle<ndim>&, NeighbourList<HydroNeib>&);
+  virtual void ComputeSymmetricSphHydroForces(GradhSphParticle<ndim>&, NeighbourList<HydroNeib>&);
+  virtual void FinishSphHydroForces(GradhSphParticle<ndim>&);
   void ComputeStarGravForces(const int, NbodyParticle<ndim> **, SphParticle<ndim> &);
 #if defined MPI_PARALLEL
   virtual void FinishReturnExport ();
@@ -319,7 +325,8 @@ class SM2012Sph: public Sph<ndim>
   virtual int DeleteDeadParticles(void) {
     return this->template DoDeleteDeadParticles<SM2012SphParticle>() ;
   }
-  virtual int ComputeH(SphParticle<ndim> &, FLOAT, const vector<DensityParticle> &, Nbody<ndim> *);
+  virtual int ComputeH(SphParticle<ndim> &, const FLOAT, const int, const FLOAT *,
+                       const FLOAT *, const vector<DensityParticle> &, Nbody<ndim> *);
   void ComputeThermalProperties(SphParticle<ndim> &);
   void ComputeSphHydroForces(const int, const int, const int *, const FLOAT *, const FLOAT *,
                              const FLOAT *, SphParticle<ndim> &, SphParticle<ndim>* );
@@ -90,6 +90,7 @@ class SphNeighbourSearch : public virtual NeighbourSearch<ndim>
   virtual void UpdateAllSphHydroForces(Sph<ndim> *, Nbody<ndim> *, DomainBox<ndim> &) =0;
   virtual void UpdateAllSphForces(Sph<ndim> *, Nbody<ndim> *,
                                   DomainBox<ndim> &, Ewald<ndim> *) = 0;
+  virtual void SetSymmetricHydroForces(const bool) {};
 
 };
 
@@ -223,6 +224,10 @@ private:
   virtual void UpdateAllSphHydroForces(Sph<ndim> *, Nbody<ndim> *, DomainBox<ndim> &);
   virtual void UpdateAllSphForces(Sph<ndim> *, Nbody<ndim> *,
                                   DomainBox<ndim> &, Ewald<ndim> *);
+  virtual void SetSymmetricHydroForces(const bool _symmetric) {symmetric_forces = _symmetric;}
+
+
+  bool symmetric_forces;               ///< Compute each hydro force pair once only
 
 };
 
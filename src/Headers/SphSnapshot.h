@@ -30,17 +30,20 @@
 #include <map>
 #include <string>
 #include <vector>
+#include "Constants.h"
 #include "Precision.h"
 #include "Sph.h"
 #include "Simulation.h"
 #include "UnitInfo.h"
 #include "BinaryOrbit.h"
+#include "ChunkedSnapshot.h"
 using namespace std;
 
 class Species {
 public:
   typedef map<string,vector<SNAPFLOAT> > maptype;
   map<string,vector<SNAPFLOAT> > values;
+  map<string,SNAPFLOAT*> mapped;       // Fields used directly from a memory-mapped file
   int N;
   string name;
 
@@ -52,6 +55,7 @@ public:
     for (maptype::iterator it=values.begin(); it != values.end(); it++) {
       it->second.clear();
     }
+    mapped.clear();
   }
 
   bool IsAllocated() {
@@ -65,10 +69,11 @@ public:
   }
 
   int CalculateMemoryUsage() {
-    if (IsAllocated() )
-      return CalculatePredictedMemoryUsage();
-    else
-      return 0;
+    int result=0;
+    for (maptype::iterator it=values.begin(); it != values.end(); it++) {
+      result += it->second.size()*sizeof(SNAPFLOAT);
+    }
+    return result;
   }
 
   int CalculatePredictedMemoryUsage() {
@@ -105,13 +110,25 @@ class SphSnapshotBase
   typedef MapData::iterator DataIterator;
   map<string, Species> data;
 
+  SimUnit* GetFieldUnit(string);
+  bool IsFieldSelected(string);
+  bool IsFieldLoaded(string, string);
+  void SelectedFieldNames(string, vector<string> &);
+  void LoadMappedField(string, string);
+  void UnmapFile(void);
+
+  ChunkedSnapshotReader* mapreader;    ///< Index of memory-mapped chunked snapshot file
+  char* mapping;                       ///< Start of memory-mapped snapshot file
+  size_t mapsize;                      ///< Size of memory-mapped snapshot file
+  vector<int> mapptype;                ///< Types of hydro particles in memory-mapped file
+
  public:
 
   static SphSnapshotBase* SphSnapshotFactory(string filename,
                                              SimulationBase* sim, int ndim);
 
   SphSnapshotBase(SimUnits*, string="");
-  //virtual ~SphSnapshotBase();
+  virtual ~SphSnapshotBase();
 
 
   // Snapshot function prototypes
@@ -129,6 +146,9 @@ class SphSnapshotBase
                         double& scaling_factor, string RequestedUnit);
 #endif
   virtual void ReadSnapshot(string)=0;
+  void SelectFields(string);
+  void SelectRegion(double, double, double=-big_number, double=big_number,
+                    double=-big_number, double=big_number);
   int GetNTypes() {return _species.size(); };
   string GetSpecies(int ispecies) { return _species.at(ispecies); };
   string GetRealType(string);
@@ -137,6 +157,7 @@ class SphSnapshotBase
   // All variables
   //-----------------------------------------------------------------------------------------------
   bool allocated;                   ///< Is snapshot memory allocated?
+  bool regionselected;              ///< Only read particles inside selected region?
   //bool allocatedbinary;             ///< Is SPH particle memory allocated?
   //bool allocatedsph;                ///< Is SPH particle memory allocated?
   //bool allocatedstar;               ///< Is star particle memory allocated?
@@ -158,6 +179,9 @@ class SphSnapshotBase
   //int Nstarmax;                     ///< Max. no. of star particles
   //int Ntriple;                      ///< No. of triple systems
   SNAPFLOAT t;                         ///< Simulation time of snapshot
+  double rselmin[3];                ///< Minimum extent of selected region (file units)
+  double rselmax[3];                ///< Maximum extent of selected region (file units)
+  vector<string> selectedfields;    ///< Names of fields to read (empty = all fields)
 
   string filename;                  ///< Filename of snapshot
   string fileform;                  ///< File format of snapshot
@@ -186,6 +210,8 @@ public:
   //~SphSnapshot() {};
   void CopyDataFromSimulation();
   void ReadSnapshot(string);
+  void ReadChunkedSnapshot(void);
+  void MapChunkedSnapshot(void);
 
   Simulation<ndims>* simulation;
 };
@@ -95,6 +95,8 @@ protected:
 	virtual void StockTree(Particle<ndim> *, bool) = 0 ;
 	virtual void UpdateActiveParticleCounters(Particle<ndim> *) = 0;
 	virtual void ExtrapolateCellProperties(const FLOAT) = 0 ;
+	// Trees without an incremental refit are simply re-stocked
+	virtual void RefitTree(Particle<ndim> *part_gen, const FLOAT) {StockTree(part_gen, true);}
 
 
     virtual MAC_Type GetMacType() const  = 0;
@@ -112,11 +114,17 @@ protected:
 	                                 const int, int &, int *, Particle<ndim> *) = 0 ;
 	virtual void ComputeNeighbourList(const TreeCellBase<ndim> &cell,NeighbourManagerBase& neibmanager)=0;
 	virtual void ComputeNeighbourAndGhostList(const TreeCellBase<ndim> &, NeighbourManagerBase&) = 0 ;
+	virtual void SetNeighbourSkin(const FLOAT) = 0;
+	virtual void SetGravityCutoff(const FLOAT) = 0;
+	virtual void UpdateNeighbourCache(const Particle<ndim> *, const bool) = 0;
 	virtual void ComputeGravityInteractionAndGhostList(const TreeCellBase<ndim> &,
 	                                                   NeighbourManagerDim<ndim>& neibmanager)=0;
 	virtual int ComputeStarGravityInteractionList(const NbodyParticle<ndim> *, const FLOAT, const int,
 	                                              const int, const int, int &, int &, int &, int *, int *,
 	                                              MultipoleMoment<ndim> *, Particle<ndim> *) = 0;
+	virtual void ComputeFmmExpansions(void) = 0;
+	virtual void ComputeFmmNearList(const TreeCellBase<ndim> &, NeighbourManagerDim<ndim>&) = 0;
+	virtual const FmmLocalExpansion<ndim>& GetFmmExpansion(const int c) const = 0;
 #if defined(MPI_PARALLEL)
 	virtual int ComputeImportedCellList(vector<TreeCellBase<ndim> >& ) = 0;
 	int GetNLeafCells() {return Nleaf_indices.size();};
@@ -238,7 +246,8 @@ protected:
     	   TreeBase<ndim>(domain),
     gravity_mac(geometric), multipole(_multipole), Nleafmax(_Nleafmax),
     invthetamaxsqd(1.0/_thetamaxsqd), kernrange(_kernrange), macerror(_macerror),
-    theta(sqrt(_thetamaxsqd)), thetamaxsqd(_thetamaxsqd),
+    theta(sqrt(_thetamaxsqd)), thetamaxsqd(_thetamaxsqd), rcutgrav(0.0),
+    neibskin(0.0), drskin(0.0), dhskin(0.0),
     gravmask(pt_reg.gravmask), IAmPruned(_IAmPruned)
     {
       if (_gravity_mac == "eigenmac")
@@ -289,10 +298,16 @@ protected:
                            const int, int &, int *, Particle<ndim> *);
   void ComputeNeighbourList(const TreeCellBase<ndim> &cell,NeighbourManagerBase& neibmanager);
   void ComputeNeighbourAndGhostList(const TreeCellBase<ndim> &, NeighbourManagerBase&);
+  void SetNeighbourSkin(const FLOAT _neibskin) {neibskin = _neibskin;}
+  void SetGravityCutoff(const FLOAT _rcutgrav) {rcutgrav = _rcutgrav;}
+  void UpdateNeighbourCache(const Particle<ndim> *, const bool);
   void ComputeGravityInteractionAndGhostList(const TreeCellBase<ndim> &, NeighbourManagerDim<ndim>& neibmanager);
   int ComputeStarGravityInteractionList(const NbodyParticle<ndim> *, const FLOAT, const int,
                                         const int, const int, int &, int &, int &, int *, int *,
                                         MultipoleMoment<ndim> *, Particle<ndim> *);
+  void ComputeFmmExpansions(void);
+  void ComputeFmmNearList(const TreeCellBase<ndim> &, NeighbourManagerDim<ndim>&);
+  const FmmLocalExpansion<ndim>& GetFmmExpansion(const int c) const {return fmmlocal[c];}
 
   virtual bool ComputeSignalVelocityFromDistantInteractions(const TreeCellBase<ndim>& cell,
                                                             int Nactive, Particle<ndim>* active_gen,
@@ -380,8 +395,28 @@ protected:
   const FLOAT macerror;                ///< Error tolerance for gravity tree-MAC
   const FLOAT theta;                   ///< Geometric opening angle
   const FLOAT thetamaxsqd;             ///< Geometric opening angle squared
+  FLOAT rcutgrav;                      ///< Cut-off radius of (short-range) gravity (0 = none)
 
 
+  // Cached (Verlet) neighbour lists
+  //-----------------------------------------------------------------------------------------------
+  FLOAT neibskin;                      ///< Skin of cached lists (in units of kernrange*cell.hmax)
+  FLOAT drskin;                        ///< Max. particle displacement since cache reset
+  FLOAT dhskin;                        ///< Max. change in smoothing length since cache reset
+  vector<FLOAT> rskin;                 ///< Particle positions at cache reset
+  vector<FLOAT> hskin;                 ///< Particle smoothing lengths at cache reset
+  vector<vector<int> > neibcache;      ///< Cached neighbour candidate lists of each cell
+  vector<FLOAT> neibcacheskin;         ///< Skin of each cached list (negative if not cached)
+  vector<FLOAT> neibcachedrift;        ///< Value of 2*drskin + kernrange*dhskin at list creation
+  vector<char> neibcacheexpired;       ///< Flags if the cached list of a cell has expired
+
+
+  // Dual-tree fast multipole method
+  //-----------------------------------------------------------------------------------------------
+  vector<FmmLocalExpansion<ndim> > fmmlocal;  ///< Local expansions of all cells
+  vector<vector<int> > fmmnear;        ///< Near-field leaf cells of each active leaf cell
+  vector<char> fmmactive;              ///< Flags if cell contains any active particles
+
 
   // Additional variables for tree class
   //-----------------------------------------------------------------------------------------------
@@ -431,6 +466,17 @@ protected:
     return open ;
   }
 
+  // Symmetric MAC for a pair of cells in the dual-tree walk, using the (non-periodic) distance
+  // between the cells, drsqd, and the distance to the nearest periodic replica, drpsqd
+  bool fmm_well_separated(const TreeCell<ndim>& cella, const TreeCell<ndim>& cellb,
+                          double drsqd, double drpsqd) const
+  {
+    const FLOAT hrangemax = kernrange*max(cella.hmax, cellb.hmax);
+    if (drpsqd <= pow(cella.rmax + cellb.rmax + hrangemax, 2)) return false;
+    return !open_cell_for_gravity(cella, drsqd, cellb.macfactor, cellb.amin) &&
+      !open_cell_for_gravity(cellb, drsqd, cella.macfactor, cella.amin);
+  }
+
 };
 
 #endif
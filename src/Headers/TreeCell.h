@@ -8,6 +8,12 @@
 #ifndef SRC_HEADERS_TREECELL_H_
 #define SRC_HEADERS_TREECELL_H_
 
+#include <math.h>
+
+
+static const int Noctupole = 10;       ///< No. of packed octupole components (for ndim = 3)
+static const int Nhexadecapole = 15;   ///< No. of packed hexadecapole components (for ndim = 3)
+
 
 //=================================================================================================
 //  Struct TreeCellBase
@@ -39,6 +45,9 @@ struct TreeCellBase {
   FLOAT drmaxdt;                       ///< Rate of change of bounding sphere
   FLOAT dhmaxdt;                       ///< Rate of change of maximum h
   FLOAT q[5];                          ///< Quadrupole moment tensor
+  FLOAT qtrace;                        ///< Trace of (raw) second moment, i.e. sum of m*dr^2
+  FLOAT q3[Noctupole];                 ///< Octupole moment tensor (packed, see SymTensorIndex)
+  FLOAT q4[Nhexadecapole];             ///< Hexadecapole moment tensor (packed)
   union {
     FLOAT amin;                        ///< Minimum grav accel of particles in the cell
     FLOAT macfactor;                   ///< Potential based accuracy factor.
@@ -58,6 +67,8 @@ struct MultipoleMoment {
   {
     for (int k=0; k<ndim; k++) r[k] = 0 ;
     for (int k=0; k<5; k++) q[k] = 0 ;
+    for (int k=0; k<Noctupole; k++) q3[k] = 0 ;
+    for (int k=0; k<Nhexadecapole; k++) q4[k] = 0 ;
     m = 0;
     id = 0;
   }
@@ -66,6 +77,8 @@ struct MultipoleMoment {
   {
     for (int k=0; k<ndim; k++) r[k] = cell.r[k] ;
     for (int k=0; k<5; k++) q[k] = cell.q[k] ;
+    for (int k=0; k<Noctupole; k++) q3[k] = cell.q3[k] ;
+    for (int k=0; k<Nhexadecapole; k++) q4[k] = cell.q4[k] ;
     m = cell.m;
     id = cell.id;
   }
@@ -73,10 +86,325 @@ struct MultipoleMoment {
   FLOAT r[ndim];                       ///< Position of cell COM
   FLOAT m;                             ///< Mass contained in cell
   FLOAT q[5];                          ///< Quadrupole moment tensor
+  FLOAT q3[Noctupole];                 ///< Octupole moment tensor (packed)
+  FLOAT q4[Nhexadecapole];             ///< Hexadecapole moment tensor (packed)
   int id ;
 };
 
 
 
 
+//=================================================================================================
+//  FmmTensorIndex
+/// Index of element (i,j) of a symmetric ndim x ndim tensor stored in packed form, i.e. in the
+/// order xx, xy, yy, xz, yz, zz.
+//=================================================================================================
+inline int FmmTensorIndex(const int i, const int j)
+{
+  return (i <= j) ? (j*(j + 1))/2 + i : (i*(i + 1))/2 + j;
+}
+
+
+
+//=================================================================================================
+//  SymTensorIndex
+/// Index of element (i,j,k) or (i,j,k,l) of a fully symmetric 3rd or 4th order tensor stored in
+/// packed form.  Elements are ordered by their sorted indices (a <= b <= c <= d) with the last
+/// index varying slowest, so the packed components of lower-dimensional tensors come first.
+//=================================================================================================
+inline int SymTensorIndex(int i, int j, int k)
+{
+  int t;
+  if (i > j) {t = i; i = j; j = t;}
+  if (j > k) {t = j; j = k; k = t;}
+  if (i > j) {t = i; i = j; j = t;}
+  return (k*(k + 1)*(k + 2))/6 + (j*(j + 1))/2 + i;
+}
+inline int SymTensorIndex(int i, int j, int k, int l)
+{
+  int t;
+  if (i > j) {t = i; i = j; j = t;}
+  if (k > l) {t = k; k = l; l = t;}
+  if (i > k) {t = i; i = k; k = t;}
+  if (j > l) {t = j; j = l; l = t;}
+  if (j > k) {t = j; j = k; k = t;}
+  return (l*(l + 1)*(l + 2)*(l + 3))/24 + (k*(k + 1)*(k + 2))/6 + (j*(j + 1))/2 + i;
+}
+
+
+
+//=================================================================================================
+//  AddParticleHigherMoments
+/// Add the contribution of a single particle of mass mi at position dr (relative to the cell COM)
+/// to the trace of the second moment and to the octupole (and, if order > 3, hexadecapole)
+/// moments of the cell.  Higher moments are stored as raw (i.e. not trace-free) moments.
+//=================================================================================================
+template <int ndim>
+inline void AddParticleHigherMoments
+ (TreeCellBase<ndim> &cell,            ///< [inout] Cell to add moments to
+  const FLOAT mi,                      ///< [in] Mass of particle
+  const FLOAT dr[ndim],                ///< [in] Position of particle relative to cell COM
+  const int order)                     ///< [in] Order of multipole expansion (3 or 4)
+{
+  int n = 0;
+  for (int k=0; k<ndim; k++) cell.qtrace += mi*dr[k]*dr[k];
+  for (int c=0; c<ndim; c++) {
+    for (int b=0; b<=c; b++) {
+      for (int a=0; a<=b; a++) cell.q3[n++] += mi*dr[a]*dr[b]*dr[c];
+    }
+  }
+  if (order < 4) return;
+  n = 0;
+  for (int d=0; d<ndim; d++) {
+    for (int c=0; c<=d; c++) {
+      for (int b=0; b<=c; b++) {
+        for (int a=0; a<=b; a++) cell.q4[n++] += mi*dr[a]*dr[b]*dr[c]*dr[d];
+      }
+    }
+  }
+  return;
+}
+
+
+
+//=================================================================================================
+//  AddChildHigherMoments
+/// Add the higher moments of a child cell to its parent cell, shifting them from the child COM
+/// to the parent COM.  The child's raw second moment is reconstructed from its quadrupole moment
+/// and second moment trace, so both must already be computed for the child.
+//=================================================================================================
+template <int ndim>
+inline void AddChildHigherMoments
+ (TreeCellBase<ndim> &cell,            ///< [inout] Parent cell
+  const TreeCellBase<ndim> &child,     ///< [in] Child cell
+  const int order)                     ///< [in] Order of multipole expansion (3 or 4)
+{
+  int n = 0;
+  const FLOAT mc = child.m;
+  FLOAT m2[ndim][ndim];                // Raw second moment of child
+  FLOAT s[ndim];                       // Position of child COM relative to parent COM
+
+  for (int k=0; k<ndim; k++) s[k] = child.r[k] - cell.r[k];
+  for (int k=0; k<ndim; k++) {
+    for (int kk=0; kk<ndim; kk++) {
+      if (ndim == 3 && k == 2 && kk == 2) m2[k][kk] = -(child.q[0] + child.q[2]);
+      else m2[k][kk] = child.q[FmmTensorIndex(k,kk)];
+      if (k == kk) m2[k][kk] += child.qtrace;
+      m2[k][kk] /= (FLOAT) 3.0;
+    }
+  }
+
+  for (int k=0; k<ndim; k++) cell.qtrace += mc*s[k]*s[k];
+  cell.qtrace += child.qtrace;
+
+  for (int c=0; c<ndim; c++) {
+    for (int b=0; b<=c; b++) {
+      for (int a=0; a<=b; a++) {
+        cell.q3[n] += child.q3[n] + m2[a][b]*s[c] + m2[a][c]*s[b] + m2[b][c]*s[a] +
+          mc*s[a]*s[b]*s[c];
+        n++;
+      }
+    }
+  }
+  if (order < 4) return;
+  n = 0;
+  for (int d=0; d<ndim; d++) {
+    for (int c=0; c<=d; c++) {
+      for (int b=0; b<=c; b++) {
+        for (int a=0; a<=b; a++) {
+          cell.q4[n] += child.q4[n] + child.q3[SymTensorIndex(b,c,d)]*s[a] +
+            child.q3[SymTensorIndex(a,c,d)]*s[b] + child.q3[SymTensorIndex(a,b,d)]*s[c] +
+            child.q3[SymTensorIndex(a,b,c)]*s[d] +
+            m2[a][b]*s[c]*s[d] + m2[a][c]*s[b]*s[d] + m2[a][d]*s[b]*s[c] +
+            m2[b][c]*s[a]*s[d] + m2[b][d]*s[a]*s[c] + m2[c][d]*s[a]*s[b] +
+            mc*s[a]*s[b]*s[c]*s[d];
+          n++;
+        }
+      }
+    }
+  }
+  return;
+}
+
+
+
+//=================================================================================================
+//  Struct FmmLocalExpansion
+/// \brief   Local (Taylor) expansion of the gravitational field about the centre of a tree cell.
+/// \details Used by the dual-tree fast multipole method (multipole = fmm).  Holds the potential
+///          and acceleration at the expansion centre, plus the gradient of the acceleration, due
+///          to all cells that are well-separated from the cell or from any of its parents.
+//=================================================================================================
+template<int ndim>
+struct FmmLocalExpansion {
+  FmmLocalExpansion()
+  {
+    for (int k=0; k<ndim; k++) rc[k] = 0;
+    Zero();
+  }
+
+  void Zero(void)
+  {
+    pot = 0;
+    for (int k=0; k<ndim; k++) a[k] = 0;
+    for (int k=0; k<(ndim*(ndim+1))/2; k++) q[k] = 0;
+  }
+
+  //===============================================================================================
+  //  FmmLocalExpansion::ShiftTo
+  /// Add the expansion, shifted to the centre of the given (child cell) expansion (L2L).
+  //===============================================================================================
+  void ShiftTo(FmmLocalExpansion<ndim> &child) const
+  {
+    FLOAT dr[ndim];
+    for (int k=0; k<ndim; k++) dr[k] = child.rc[k] - rc[k];
+    child.pot += pot + TaylorPotential(dr);
+    for (int k=0; k<ndim; k++) {
+      child.a[k] += a[k];
+      for (int kk=0; kk<ndim; kk++) child.a[k] += q[FmmTensorIndex(k,kk)]*dr[kk];
+    }
+    for (int k=0; k<(ndim*(ndim+1))/2; k++) child.q[k] += q[k];
+  }
+
+  //===============================================================================================
+  //  FmmLocalExpansion::Apply
+  /// Add the acceleration and potential of the expansion at position r.
+  //===============================================================================================
+  void Apply(const FLOAT r[ndim], FLOAT agrav[ndim], FLOAT &gpot) const
+  {
+    FLOAT dr[ndim];
+    for (int k=0; k<ndim; k++) dr[k] = r[k] - rc[k];
+    gpot += pot + TaylorPotential(dr);
+    for (int k=0; k<ndim; k++) {
+      agrav[k] += a[k];
+      for (int kk=0; kk<ndim; kk++) agrav[k] += q[FmmTensorIndex(k,kk)]*dr[kk];
+    }
+  }
+
+  //===============================================================================================
+  //  FmmLocalExpansion::TaylorPotential
+  /// Change of the potential (to second order) at a displacement dr from the centre.
+  //===============================================================================================
+  FLOAT TaylorPotential(const FLOAT dr[ndim]) const
+  {
+    FLOAT dpot = 0;
+    for (int k=0; k<ndim; k++) {
+      dpot += a[k]*dr[k];
+      for (int kk=0; kk<ndim; kk++) dpot += (FLOAT) 0.5*q[FmmTensorIndex(k,kk)]*dr[k]*dr[kk];
+    }
+    return dpot;
+  }
+
+  FLOAT rc[ndim];                      ///< Centre of expansion
+  FLOAT pot;                           ///< Potential at centre
+  FLOAT a[ndim];                       ///< Acceleration at centre
+  FLOAT q[(ndim*(ndim+1))/2];          ///< Gradient of acceleration (packed symmetric tensor)
+};
+
+
+
+//=================================================================================================
+//  AddFmmQuadrupole
+/// Add the quadrupole terms of a source cell to a local expansion.  dr is the vector between the
+/// source cell COM and the expansion centre, and sgn = -1 if it points from the centre to the
+/// source (+1 otherwise).  s is the (packed) tensor 7*dr_i*dr_j/dr^2 - delta_ij.
+//=================================================================================================
+template<int ndim>
+inline void AddFmmQuadrupole
+ (const TreeCellBase<ndim> &source,    ///< [in] Source cell
+  const FLOAT dr[ndim],                ///< [in] Relative position vector
+  const FLOAT sgn,                     ///< [in] Sign of relative position vector
+  const FLOAT invdrsqd,                ///< [in] 1/dr^2
+  const FLOAT invdr5,                  ///< [in] 1/dr^5
+  const FLOAT *s,                      ///< [in] Packed tensor shared by both cells
+  FmmLocalExpansion<ndim> &local)      ///< [inout] Local expansion
+{
+  FLOAT qfull[ndim][ndim];             // Full quadrupole moment tensor
+  FLOAT qdr[ndim];                     // Quadrupole tensor times dr
+  FLOAT qscalar = 0;                   // dr.Q.dr
+
+  // The zz-component is not stored in 3D since the tensor is traceless
+  for (int k=0; k<ndim; k++) {
+    for (int kk=0; kk<ndim; kk++) {
+      if (k == 2 && kk == 2) qfull[k][kk] = -(source.q[0] + source.q[2]);
+      else qfull[k][kk] = source.q[FmmTensorIndex(k,kk)];
+    }
+  }
+
+  for (int k=0; k<ndim; k++) {
+    qdr[k] = 0;
+    for (int kk=0; kk<ndim; kk++) qdr[k] += qfull[k][kk]*dr[kk];
+    qscalar += qdr[k]*dr[k];
+  }
+  const FLOAT qfactor = (FLOAT) 2.5*qscalar*invdr5*invdrsqd;
+
+  local.pot += (FLOAT) 0.5*qscalar*invdr5;
+  for (int k=0; k<ndim; k++) local.a[k] += sgn*(qdr[k]*invdr5 - qfactor*dr[k]);
+  for (int k=0; k<ndim; k++) {
+    for (int kk=k; kk<ndim; kk++) {
+      local.q[FmmTensorIndex(k,kk)] += qfactor*s[FmmTensorIndex(k,kk)] + qfull[k][kk]*invdr5 -
+        (FLOAT) 5.0*invdrsqd*invdr5*(qdr[k]*dr[kk] + qdr[kk]*dr[k]);
+    }
+  }
+}
+
+
+
+//=================================================================================================
+//  AddFmmInteraction
+/// Add the (monopole and quadrupole) field of cell b to the local expansion of cell a, and if
+/// localb is given, the field of cell a to the local expansion of cell b (M2L).  dr points from
+/// the centre of the expansion of cell a to the COM of cell b.  The expansion of cell b must be
+/// centred on its COM, and the COM of cell a must be at the centre of its expansion, if both
+/// are updated, so that all geometric terms are shared by both cells.
+//=================================================================================================
+template<int ndim>
+inline void AddFmmInteraction
+ (const FLOAT dr[ndim],                ///< [in] Relative position vector
+  const TreeCellBase<ndim> &cella,     ///< [in] Cell a
+  FmmLocalExpansion<ndim> *locala,     ///< [inout] Local expansion of cell a (or NULL)
+  const TreeCellBase<ndim> &cellb,     ///< [in] Cell b
+  FmmLocalExpansion<ndim> *localb)     ///< [inout] Local expansion of cell b (or NULL)
+{
+  FLOAT t[(ndim*(ndim+1))/2];          // 3*dr_i*dr_j/dr^2 - delta_ij
+  FLOAT s[(ndim*(ndim+1))/2];          // 7*dr_i*dr_j/dr^2 - delta_ij
+
+  FLOAT drsqd = 0;                     // Distance squared
+  for (int k=0; k<ndim; k++) drsqd += dr[k]*dr[k];
+
+  const FLOAT invdrsqd = (FLOAT) 1.0/drsqd;
+  const FLOAT invdrmag = sqrt(invdrsqd);
+  const FLOAT invdr3   = invdrsqd*invdrmag;
+  const FLOAT invdr5   = invdr3*invdrsqd;
+
+  for (int k=0; k<ndim; k++) {
+    for (int kk=k; kk<ndim; kk++) {
+      const FLOAT drdr = dr[k]*dr[kk]*invdrsqd;
+      const FLOAT delta = (k == kk) ? (FLOAT) 1.0 : (FLOAT) 0.0;
+      t[FmmTensorIndex(k,kk)] = (FLOAT) 3.0*drdr - delta;
+      s[FmmTensorIndex(k,kk)] = (FLOAT) 7.0*drdr - delta;
+    }
+  }
+
+  // Monopole terms
+  if (locala != NULL) {
+    const FLOAT mc = cellb.m*invdr3;
+    locala->pot += cellb.m*invdrmag;
+    for (int k=0; k<ndim; k++) locala->a[k] += mc*dr[k];
+    for (int k=0; k<(ndim*(ndim+1))/2; k++) locala->q[k] += mc*t[k];
+  }
+  if (localb != NULL) {
+    const FLOAT mc = cella.m*invdr3;
+    localb->pot += cella.m*invdrmag;
+    for (int k=0; k<ndim; k++) localb->a[k] -= mc*dr[k];
+    for (int k=0; k<(ndim*(ndim+1))/2; k++) localb->q[k] += mc*t[k];
+  }
+
+  // Quadrupole terms
+  if (locala != NULL) AddFmmQuadrupole(cellb, dr, (FLOAT) -1.0, invdrsqd, invdr5, s, *locala);
+  if (localb != NULL) AddFmmQuadrupole(cella, dr, (FLOAT) 1.0, invdrsqd, invdr5, s, *localb);
+}
+
+
+
 #endif /* SRC_HEADERS_TREECELL_H_ */
@@ -25,6 +25,7 @@
 #include <cstring>
 #include <cstdlib>
 #include <iostream>
+#include <algorithm>
 #include <math.h>
 #include "Precision.h"
 #include "Hydrodynamics.h"
@@ -72,6 +73,9 @@ Hydrodynamics<ndim>::Hydrodynamics(int hydro_forces_aux, int self_gravity_aux, F
   NImportedParticles = 0;
   Nmpighost          = 0;
   NPeriodicGhost     = 0;
+  levelindex_valid   = false;
+  level_sync         = 0;
+  nendstep           = -1;
   rho_sink           = params->floatparams["rho_sink"]/(units.rho.outscale*units.rho.outcgs);
   create_sinks       = params->intparams["create_sinks"];
   sink_particles     = params->intparams["sink_particles"];
@@ -146,6 +150,7 @@ Particle<ndim>& Hydrodynamics<ndim>::CreateNewParticle
 
   // Find space for new particle at the end of the array and increment relevant counters.
   sim->rebuild_tree = true;
+  levelindex_valid  = false;
   int inew = Nhydro++;
   Ntot++;
   Particle<ndim> &part = GetParticlePointer(inew);
@@ -180,6 +185,122 @@ Particle<ndim>& Hydrodynamics<ndim>::CreateNewParticle
 
 
 
+//=================================================================================================
+//  Hydrodynamics::FindEndOfStepParticles
+/// Find all particles which can be at the end of their timestep at integer time n, i.e. all
+/// particles on the timestep levels synchronised at n (level >= level_sync), and store their
+/// i.d.s in endsteplist.  Since particle steps are aligned with their own level, these are
+/// exactly the particles with n - nlast == nstep, so the list costs O(Nactive) to build.
+/// If the level index is not up-to-date, all live particles are returned instead (O(N)).
+/// Returns the length of the list.
+//=================================================================================================
+template <int ndim>
+int Hydrodynamics<ndim>::FindEndOfStepParticles
+ (const int n,                         ///< [in] Integer time in block time struct
+  const int level_step)                ///< [in] Level of base timestep
+{
+  int i;                               // Particle counter
+  int l;                               // Timestep level counter
+
+  debug2("[Hydrodynamics::FindEndOfStepParticles]");
+
+  endsteplist.clear();
+
+  // If the index is invalid (e.g. particles have been created, removed or re-ordered, or
+  // levels have been changed outside of the block timestep routine), return all particles
+  //-----------------------------------------------------------------------------------------------
+  if (!levelindex_valid) {
+    level_sync = 0;
+    endsteplist.reserve(Nhydro);
+    for (i=0; i<Nhydro; i++) {
+      if (!GetParticlePointer(i).flags.is_dead()) endsteplist.push_back(i);
+    }
+    return endsteplist.size();
+  }
+
+  // Otherwise find the lowest synchronised level (all finer levels are also synchronised)
+  // and collect all particles on these levels in memory order
+  //-----------------------------------------------------------------------------------------------
+  level_sync = levelindex.size();
+  while (level_sync > 0 &&
+         (level_sync - 1 >= level_step || n%(1 << (level_step - level_sync + 1)) == 0)) {
+    level_sync--;
+  }
+
+  for (l=level_sync; l<(int) levelindex.size(); l++) {
+    for (i=0; i<(int) levelindex[l].size(); i++) {
+      if (!GetParticlePointer(levelindex[l][i]).flags.is_dead()) {
+        endsteplist.push_back(levelindex[l][i]);
+      }
+    }
+  }
+  std::sort(endsteplist.begin(), endsteplist.end());
+
+  return endsteplist.size();
+}
+
+
+
+//=================================================================================================
+//  Hydrodynamics::UpdateLevelIndex
+/// Move all particles in endsteplist to the buckets of their (new) timestep levels once the
+/// block timesteps have been computed.  Only the synchronised levels are touched, so the cost
+/// is O(Nactive) (or O(N) if the index was rebuilt in FindEndOfStepParticles).
+//=================================================================================================
+template <int ndim>
+void Hydrodynamics<ndim>::UpdateLevelIndex
+ (const int n)                         ///< [in] (Possibly re-scaled) integer time
+{
+  int j;                               // Aux. counter
+  int l;                               // Timestep level counter
+
+  debug2("[Hydrodynamics::UpdateLevelIndex]");
+
+  for (l=level_sync; l<(int) levelindex.size(); l++) levelindex[l].clear();
+
+  for (j=0; j<(int) endsteplist.size(); j++) {
+    const int i = endsteplist[j];
+    const int level = GetParticlePointer(i).level;
+    if (level >= (int) levelindex.size()) levelindex.resize(level + 1);
+    levelindex[level].push_back(i);
+  }
+
+  levelindex_valid = true;
+  nendstep = n;
+
+  return;
+}
+
+
+
+//=================================================================================================
+//  Hydrodynamics::MaxInactiveLevel
+/// Return the highest timestep level occupied by live particles which are not synchronised at
+/// the current step (i.e. below level_sync), and the timestep of these particles, which is the
+/// smallest of all particles not in endsteplist.  Returns 0 and big_number_dp if there are none.
+//=================================================================================================
+template <int ndim>
+int Hydrodynamics<ndim>::MaxInactiveLevel
+ (DOUBLE &dt)                          ///< [out] Timestep of particles on returned level
+{
+  int i;                               // Aux. counter
+  int l;                               // Timestep level counter
+
+  dt = big_number_dp;
+  for (l=min(level_sync, (int) levelindex.size())-1; l>=0; l--) {
+    for (i=0; i<(int) levelindex[l].size(); i++) {
+      const Particle<ndim>& part = GetParticlePointer(levelindex[l][i]);
+      if (part.flags.is_dead()) continue;
+      dt = part.dt;
+      return l;
+    }
+  }
+
+  return 0;
+}
+
+
+
 //=================================================================================================
 //  Hydrodynamics::ComputeBoundingBox
 /// Calculate the bounding box containing all hydro particles.
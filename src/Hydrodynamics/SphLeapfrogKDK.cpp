@@ -223,6 +223,7 @@ void SphLeapfrogKDK<ndim, ParticleType>::EndTimestep
   Hydrodynamics<ndim>* hydro)
 {
   int i;                               // Particle counter
+  int j;                               // Aux. particle counter
   int k;                               // Dimension counter
 
   debug2("[SphLeapfrogKDK::EndTimestep]");
@@ -231,9 +232,15 @@ void SphLeapfrogKDK<ndim, ParticleType>::EndTimestep
   Sph<ndim>* sph = reinterpret_cast<Sph<ndim>*>(hydro);
   ParticleType<ndim>* sphdata = reinterpret_cast<ParticleType<ndim>*>(sph->GetSphParticleArray());
 
+  // Only particles on the timestep levels synchronised at n can be at the end of their step,
+  // so loop over the list of these particles if it is available (otherwise over all particles)
+  bool uselist = sph->UseEndOfStepList(n);
+  int Nloop = uselist ? (int) sph->endsteplist.size() : sph->Nhydro;
+
   //-----------------------------------------------------------------------------------------------
-#pragma omp parallel for default(none) private(i,k) shared(sphdata, sph)
-  for (i=0; i<sph->Nhydro; i++) {
+#pragma omp parallel for default(none) private(i,k) shared(sphdata, sph, uselist, Nloop)
+  for (j=0; j<Nloop; j++) {
+    i = uselist ? sph->endsteplist[j] : j;
     SphParticle<ndim>& part = sphdata[i];
     if (part.flags.is_dead()) continue;
 
@@ -325,6 +332,9 @@ int SphLeapfrogKDK<ndim, ParticleType>::CheckTimesteps
   }
   //-----------------------------------------------------------------------------------------------
 
+  // Particles have been moved to new levels, so the per-level index must be rebuilt
+  if (activecount > 0) sph->InvalidateLevelIndex();
+
   return activecount;
 }
 
@@ -143,6 +143,13 @@ void SphSimulation<ndim>::ProcessParameters(void)
     ExceptionHandler::getIstance().raise(message);
   }
 
+  // Symmetric (pair-wise) hydro forces are only implemented for grad-h SPH
+  if (intparams["symmetric_hydro_forces"] == 1 && sim == "sm2012sph") {
+    string message = "Invalid parameter : symmetric_hydro_forces is only available for "
+      "grad-h SPH";
+    ExceptionHandler::getIstance().raise(message);
+  }
+
 #if defined MPI_PARALLEL
   sinks->SetMpiControl(mpicontrol);
   if (stringparams["out_file_form"]=="sf") {
@@ -150,6 +157,10 @@ void SphSimulation<ndim>::ProcessParameters(void)
         "or (better) the su format";
     ExceptionHandler::getIstance().raise(message);
   }
+  if (intparams["symmetric_hydro_forces"] == 1) {
+    string message = "The symmetric_hydro_forces option is not supported with MPI";
+    ExceptionHandler::getIstance().raise(message);
+  }
 #endif
 
   // Supernova feedback
@@ -181,6 +192,11 @@ void SphSimulation<ndim>::ProcessParameters(void)
     sinks->timing    = timing;
     hydroint->timing  = timing;
     sphneib->SetTimingObject(timing);
+    sphneib->SetParticleReordering(intparams["nreorderstep"], stringparams["sfc_curve"]);
+    sphneib->SetNeighbourSkin(floatparams["neib_skin"]);
+    if (simbox.PeriodicGravity && ewald->pm != NULL) sphneib->SetGravityCutoff(ewald->pm->rcut);
+    sphneib->SetTreeRefit(intparams["tree_refit"], floatparams["tree_refit_tol"]);
+    sphneib->SetSymmetricHydroForces(intparams["symmetric_hydro_forces"] == 1);
     uint->timing    = timing;
     radiation->timing = timing;
   }
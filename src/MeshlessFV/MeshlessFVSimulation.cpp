@@ -370,6 +370,10 @@ void MeshlessFVSimulation<ndim>::ProcessParameters(void)
   //if (sim == "sph" || sim == "gradhsph" || sim == "sm2012sph" || sim == "godunov_hydro") {
   sinks->timing    = timing;
   mfvneib->SetTimingObject(timing);
+  mfvneib->SetParticleReordering(intparams["nreorderstep"], stringparams["sfc_curve"]);
+  mfvneib->SetNeighbourSkin(floatparams["neib_skin"]);
+  if (simbox.PeriodicGravity && ewald->pm != NULL) mfvneib->SetGravityCutoff(ewald->pm->rcut);
+  mfvneib->SetTreeRefit(intparams["tree_refit"], floatparams["tree_refit_tol"]);
   mfv->timing = timing;
   hydroint->timing = timing;
   uint->timing = timing;
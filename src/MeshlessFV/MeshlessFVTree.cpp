@@ -304,6 +304,7 @@ void MeshlessFVTree<ndim,ParticleType>::UpdateAllProperties
 
   // Update tree smoothing length values here
   tree->UpdateAllHmaxValues(mfvdata);
+  tree->UpdateNeighbourCache(mfvdata, false);
 
   return;
 }
@@ -690,6 +691,17 @@ void MeshlessFVTree<ndim,ParticleType>::UpdateAllGravForces
     return;
   }
 
+  // Compute the local expansions of all active cells with the dual-tree walk
+  if (multipole == "fmm" && mfv->self_gravity == 1) {
+    CodeTiming::BlockTimer fmmtimer = timing->StartNewTimer("FMM_EXPANSIONS");
+    tree->ComputeFmmExpansions();
+  }
+
+  // Compute the long-range (mesh) part of the periodic gravity for TreePM
+  if (mfv->self_gravity == 1 && simbox.PeriodicGravity && ewald->pm != NULL) {
+    ewald->pm->ComputeMeshField(mfv, nbody);
+  }
+
   // Set-up all OMP threads
   //===============================================================================================
 #pragma omp parallel default(none) shared(celllist,cactive,ewald,mfv,nbody,partdata,simbox,cout)
@@ -744,7 +756,8 @@ void MeshlessFVTree<ndim,ParticleType>::UpdateAllGravForces
 
         // Compute neighbour list for cell depending on physics options
         neibmanager.clear();
-        tree->ComputeGravityInteractionAndGhostList(cell, neibmanager);
+        if (multipole == "fmm") tree->ComputeFmmNearList(cell, neibmanager);
+        else tree->ComputeGravityInteractionAndGhostList(cell, neibmanager);
         neibmanager.EndSearchGravity(cell,partdata);
 
         MultipoleMoment<ndim>* gravcell;
@@ -778,6 +791,14 @@ void MeshlessFVTree<ndim,ParticleType>::UpdateAllGravForces
               ComputeCellQuadrupoleForces(activepart[j].gpot, activepart[j].atree,
                                           activepart[j].r, Ngravcell, gravcell);
             }
+            else if (multipole == "octupole") {
+              ComputeCellMultipoleForces(3, activepart[j].gpot, activepart[j].atree,
+                                            activepart[j].r, Ngravcell, gravcell);
+            }
+            else if (multipole == "hexadecapole") {
+              ComputeCellMultipoleForces(4, activepart[j].gpot, activepart[j].atree,
+                                            activepart[j].r, Ngravcell, gravcell);
+            }
 
             // Add the periodic correction force for SPH and direct-sum neighbours
             if (simbox.PeriodicGravity) {
@@ -798,6 +819,12 @@ void MeshlessFVTree<ndim,ParticleType>::UpdateAllGravForces
                 for (int k=0; k<ndim; k++) activepart[j].atree[k] += aperiodic[k];
                 activepart[j].gpot += potperiodic;
               }
+
+              // Add the long-range force interpolated from the mesh for TreePM
+              if (ewald->pm != NULL) {
+                ewald->pm->InterpolateMeshForces(activepart[j].r, activepart[j].atree,
+                                                 activepart[j].gpot);
+              }
             }
           }
         }
@@ -811,6 +838,9 @@ void MeshlessFVTree<ndim,ParticleType>::UpdateAllGravForces
         else if (multipole == "fast_quadrupole") {
           ComputeFastQuadrupoleForces(Nactive, Ngravcell, gravcell, cell, activepart, mfv->types);
         }
+        else if (multipole == "fmm") {
+          ComputeFmmForces(Nactive, tree->GetFmmExpansion(cell.id), activepart, mfv->types);
+        }
       } // End of self-gravity for this cell
 
       // Save the hydro potential (radws cooling)
@@ -825,6 +855,20 @@ void MeshlessFVTree<ndim,ParticleType>::UpdateAllGravForces
         }
       }
 
+      // For TreePM, the long-range part of the star forces comes from the mesh, so only keep the
+      // short-range part of the (direct) star forces
+      if (simbox.PeriodicGravity && ewald->pm != NULL) {
+        for (int j=0; j<Nactive; j++) {
+          if (activelist[j] >= mfv->Nhydro) continue;
+          for (int s=0; s<nbody->Nnbody; s++) {
+            for (int k=0; k<ndim; k++) draux[k] = nbody->nbodydata[s]->r[k] - activepart[j].r[k];
+            ewald->CalculatePeriodicCorrection(nbody->nbodydata[s]->m, draux, aperiodic, potperiodic);
+            for (int k=0; k<ndim; k++) activepart[j].atree[k] += aperiodic[k];
+            activepart[j].gpot += potperiodic;
+          }
+        }
+      }
+
       // Add all active particles contributions to main array
       for (int j=0; j<Nactive; j++) {
         const int i = activelist[j];
@@ -154,6 +154,9 @@ int MfvCommon<ndim, kernelclass,SlopeLimiter>::ComputeH
 
     // Loop over all nearest neighbours in list to calculate density, omega and zeta.
     //---------------------------------------------------------------------------------------------
+#if defined(GANDALF_SIMD)
+#pragma omp simd reduction(+:ndens,invomega,zeta) private(ssqd)
+#endif
     for (j=0; j<Nneib; j++) {
       ssqd      = drsqd[j]*invhsqd;
       ndens    += kern.w0_s2(ssqd);
@@ -245,11 +248,12 @@ void MfvCommon<ndim, kernelclass,SlopeLimiter>::ComputeGradients
 {
   int k;                                       // Dimension counter
   int var;                                     // Primitive variable counter
-  FLOAT draux[ndim], dv[ndim];                 // Relative position / velocity vector
-  FLOAT drsqd;                                 // Distance squared
+  KFLOAT draux[ndim];                          // Relative position vector
+  FLOAT dv[ndim];                              // Relative velocity vector
+  KFLOAT drsqd;                                // Distance squared
   FLOAT dvdr ;                                 // Delta v , Delta r
   FLOAT E[ndim][ndim];                         // E-matrix for computing normalised B-matrix
-  const FLOAT invhsqd = 1/(part.h*part.h);     // Local copy of 1/h^2
+  const KFLOAT invhsqd = (KFLOAT) (1/(part.h*part.h));  // Local copy of 1/h^2
   FLOAT grad_tmp[nvar][ndim] ;                 // Workspace for computing gradient
 
   // Initialise/zero all variables to be updated in this routine
@@ -273,7 +277,7 @@ void MfvCommon<ndim, kernelclass,SlopeLimiter>::ComputeGradients
   int Nneib = neibpart.size();
   for (int j=0; j<Nneib; j++) {
 
-    for (k=0; k<ndim; k++) draux[k] = neibpart[j].r[k] - part.r[k];
+    for (k=0; k<ndim; k++) draux[k] = (KFLOAT) (neibpart[j].r[k] - part.r[k]);
     for (k=0; k<ndim; k++) dv[k] = neibpart[j].v[k] - part.v[k];
     drsqd = DotProduct(draux, draux, ndim);
     dvdr = DotProduct(dv, draux, ndim);
@@ -223,6 +223,7 @@ int MfvIntegration<ndim,ParticleType>::CheckTimesteps
   int level_new;                       // New timestep level
   int nnewstep;                        // New integer timestep
   int activecount = 0;                 // No. of newly active particles
+  int Nchanged = 0;                    // No. of particles moved to a new level
   int i;                               // Particle counter
 
   MeshlessFV<ndim>* mfv = reinterpret_cast<MeshlessFV<ndim>*>(hydro) ;
@@ -238,7 +239,7 @@ int MfvIntegration<ndim,ParticleType>::CheckTimesteps
   int nvar = MeshlessFV<ndim>::nvar;
   //-----------------------------------------------------------------------------------------------
   #pragma omp parallel for default(none) private(dn,i,level_new,nnewstep) \
-    shared(mfvdata,cout,mfv, nvar) reduction(+:activecount)
+    shared(mfvdata,cout,mfv, nvar) reduction(+:activecount,Nchanged)
   for (i=0; i<mfv->Nhydro; i++) {
     MeshlessFVParticle<ndim>& part = mfvdata[i];
     if (part.flags.is_dead()) continue;
@@ -261,11 +262,15 @@ int MfvIntegration<ndim,ParticleType>::CheckTimesteps
           part.dQ[var] = part.dt * part.dQdt[var];
 
         part.flags.set(active);
+        Nchanged++;
       }
     }
   }
     //-----------------------------------------------------------------------------------------------
 
+  // Particles have been moved to new levels, so the per-level index must be rebuilt
+  if (Nchanged > 0) mfv->InvalidateLevelIndex();
+
   return activecount;
  }
 
@@ -461,6 +461,7 @@ void MpiKDTreeDecomposition<ndim, ParticleType >::LoadBalancing
       running_counter++;
     }
     hydro->Nhydro = running_counter;
+    hydro->InvalidateLevelIndex();
 
   }
   //-----------------------------------------------------------------------------------------------
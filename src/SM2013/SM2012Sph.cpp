@@ -132,7 +132,10 @@ void SM2012Sph<ndim, kernelclass>::DeallocateMemory(void)
 template <int ndim, template<int> class kernelclass>
 int SM2012Sph<ndim, kernelclass >::ComputeH
  (SphParticle<ndim> &part,                                ///< [inout] Particle i data
-  FLOAT hmax,                                             ///< [in] Maximum smoothing length
+  const FLOAT hmax,                                       ///< [in] Maximum smoothing length
+  const int Nneib,                                        ///< [in] No. of potential neighbours
+  const FLOAT *m,                                         ///< [in] Array of neighbour masses
+  const FLOAT *drsqd,                                     ///< [in] Array of neib. distances sqd
   const vector<DensityParticle> &ngbs,                    ///< [in] Neighbour properties
   Nbody<ndim> *nbody)                                     ///< [in] Main N-body object
 {
@@ -149,7 +152,6 @@ int SM2012Sph<ndim, kernelclass >::ComputeH
   SM2012SphParticle<ndim>& parti = static_cast<SM2012SphParticle<ndim>& > (part);
 
   FLOAT invh ;
-  int Nneib = ngbs.size();
 
   // Main smoothing length iteration loop
   //===============================================================================================
@@ -168,11 +170,9 @@ int SM2012Sph<ndim, kernelclass >::ComputeH
     // density.
     //---------------------------------------------------------------------------------------------
     for (j=0; j<Nneib; j++) {
-      const DensityParticle &ngb = ngbs[j];
-      for (k=0; k<ndim; k++) dr[k] = ngb.r[k] - parti.r[k];
-      w          = kern.w0_s2(invhsqd*DotProduct(dr, dr, ndim));
-      parti.rho += ngb.m*w;
-      parti.q   += ngb.m*ngb.u*w;
+      w          = kern.w0_s2(invhsqd*drsqd[j]);
+      parti.rho += m[j]*w;
+      parti.q   += m[j]*ngbs[j].u*w;
     }
     //---------------------------------------------------------------------------------------------
 
@@ -236,11 +236,8 @@ int SM2012Sph<ndim, kernelclass >::ComputeH
   if (create_sinks == 1) {
     parti.flags.set(potmin);
     for (j=0; j<Nneib; j++) {
-      const DensityParticle &ngb = ngbs[j];
-      for (k=0; k<ndim; k++) dr[k] = ngb.r[k] - parti.r[k];
-      FLOAT drsqd = DotProduct(dr,dr,ndim);
-      if (ngb.gpot > 1.000000001*parti.gpot &&
-          drsqd*invhsqd < kern.kernrangesqd) parti.flags.unset(potmin);
+      if (ngbs[j].gpot > 1.000000001*parti.gpot &&
+          drsqd[j]*invhsqd < kern.kernrangesqd) parti.flags.unset(potmin);
     }
   }
 
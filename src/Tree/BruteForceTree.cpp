@@ -342,8 +342,11 @@ void BruteForceTree<ndim,ParticleType,TreeCell>::StockTreeProperties
   FLOAT lambda = (FLOAT) 0.0;          // ..
 
 
+  const int multipole_order =
+      (multipole == "hexadecapole") ? 4 : ((multipole == "octupole") ? 3 : 2);
   const bool need_quadrupole_moments =
-      multipole == "quadrupole" || multipole == "fast_quadrupole" || gravity_mac == eigenmac ;
+      multipole == "quadrupole" || multipole == "fast_quadrupole" || multipole == "fmm" ||
+      multipole_order > 2 || gravity_mac == eigenmac ;
 
   // Zero all summation variables for all cells
   cell.Nactive  = 0;
@@ -361,6 +364,11 @@ void BruteForceTree<ndim,ParticleType,TreeCell>::StockTreeProperties
   else if (gravity_mac == eigenmac)
     cell.macfactor = 0 ;
   for (k=0; k<5; k++) cell.q[k]          = (FLOAT) 0.0;
+  if (multipole_order > 2) {
+    cell.qtrace = (FLOAT) 0.0;
+    for (k=0; k<Noctupole; k++) cell.q3[k]     = (FLOAT) 0.0;
+    for (k=0; k<Nhexadecapole; k++) cell.q4[k] = (FLOAT) 0.0;
+  }
   for (k=0; k<ndim; k++) cell.r[k]       = (FLOAT) 0.0;
   for (k=0; k<ndim; k++) cell.v[k]       = (FLOAT) 0.0;
   for (k=0; k<ndim; k++) cell.rcell[k]   = (FLOAT) 0.0;
@@ -456,6 +464,7 @@ void BruteForceTree<ndim,ParticleType,TreeCell>::StockTreeProperties
 		  cell.q[1] += mi*(FLOAT) 3.0*dr[0]*dr[1];
 		  cell.q[2] += mi*((FLOAT) 3.0*dr[1]*dr[1] - drsqd);
 		}
+		if (multipole_order > 2) AddParticleHigherMoments(cell, mi, dr, multipole_order);
 	  }
 	  if (i == cell.ilast) break;
 	  i = inext[i];
@@ -24,6 +24,7 @@
 #include <cstdlib>
 #include <cassert>
 #include <iostream>
+#include <algorithm>
 #include <numeric>
 #include <string>
 #include <math.h>
@@ -76,6 +77,11 @@ HydroTree<ndim,ParticleType>::HydroTree
 {
   allocated_buffer = false;
   neibcheck        = true;
+  nreorderstep     = 0;
+  Nrebuild         = 0;
+  sfc_curve        = hilbert;
+  tree_refit       = 0;
+  refit_tol        = (FLOAT) 0.25;
   Ntot             = 0;
   Ntotmax          = 0;
   Ntotmaxold       = 0;
@@ -321,12 +327,6 @@ void HydroTree<ndim,ParticleType>::BuildTree
   debug2("[HydroTree::BuildTree]");
 
 
-  // Activate nested parallelism for tree building routines
-#ifdef _OPENMP
-  omp_set_nested(1);
-#endif
-
-
   // For tree rebuild steps
   //-----------------------------------------------------------------------------------------------
   if (n%ntreebuildstep == 0 || rebuild_tree) {
@@ -334,6 +334,10 @@ void HydroTree<ndim,ParticleType>::BuildTree
     // Delete any dead particles from main Hydrodynamics arrays before we re-build tree
     hydro->DeleteDeadParticles();
 
+    // Re-order the particles in memory along a space-filling curve (if selected)
+    if (nreorderstep > 0 && Nrebuild%nreorderstep == 0) ReorderParticles(hydro);
+    Nrebuild++;
+
     Ntotold    = Ntot;
     Ntot       = hydro->Ntot;
     Ntotmaxold = Ntotmax;
@@ -345,13 +349,22 @@ void HydroTree<ndim,ParticleType>::BuildTree
     AllocateMemory(hydro->Ngather);
     if (Ntotmaxold < Ntotmax) ReallocateMemory();
 
+    tree->UpdateNeighbourCache(partdata, true);
+
   }
 
-  // Else stock the tree
+  // Else stock the tree (or refit it to the new particle positions if selected)
   //-----------------------------------------------------------------------------------------------
   else if (n%ntreestockstep == 0) {
 
-    tree->StockTree(partdata,true);
+    if (tree_refit) {
+      tree->RefitTree(partdata, refit_tol);
+      tree->UpdateNeighbourCache(partdata, true);
+    }
+    else {
+      tree->StockTree(partdata,true);
+      tree->UpdateNeighbourCache(partdata, false);
+    }
 
   }
 
@@ -360,13 +373,79 @@ void HydroTree<ndim,ParticleType>::BuildTree
   else {
 
     tree->ExtrapolateCellProperties(timestep);
+    tree->UpdateNeighbourCache(partdata, false);
 
   }
   //-----------------------------------------------------------------------------------------------
 
-#ifdef _OPENMP
-  omp_set_nested(0);
-#endif
+  return;
+}
+
+
+
+//=================================================================================================
+//  HydroTree::ReorderParticles
+/// Sort all real hydro particles in memory along a Peano-Hilbert or Morton space-filling curve,
+/// so particles that are neighbours in space are also (mostly) neighbours in memory.  Periodic
+/// ghosts keep their place in the array, but their iorig ids are updated to the new order.
+/// Must only be called when the tree is about to be re-built.
+//=================================================================================================
+template <int ndim, template <int> class ParticleType>
+void HydroTree<ndim,ParticleType>::ReorderParticles
+ (Hydrodynamics<ndim> *hydro)          ///< [inout] Pointer to Hydrodynamics object
+{
+  int i;                               // Particle counter
+  int j;                               // Aux. particle counter
+  int k;                               // Dimension counter
+  int Nhydro = hydro->Nhydro;          // No. of real particles to be re-ordered
+  SfcType curve = sfc_curve;           // Local copy of space-filling curve type
+  FLOAT invlength;                     // 1 / (longest side of bounding box)
+  FLOAT length = (FLOAT) 0.0;          // Longest side of bounding box
+  FLOAT rmin[ndim];                    // Minimum extent of particle bounding box
+  FLOAT rmax[ndim];                    // Maximum extent of particle bounding box
+  ParticleType<ndim> *partdata = hydro->template GetParticleArray<ParticleType>();
+
+  debug2("[HydroTree::ReorderParticles]");
+
+  if (Nhydro < 2) return;
+  CodeTiming::BlockTimer timer = timing->StartNewTimer("REORDER_PARTICLES");
+  hydro->InvalidateLevelIndex();
+
+  // Find the bounding box of all real particles
+  for (k=0; k<ndim; k++) rmin[k] = big_number;
+  for (k=0; k<ndim; k++) rmax[k] = -big_number;
+  for (i=0; i<Nhydro; i++) {
+    for (k=0; k<ndim; k++) rmin[k] = min(rmin[k], partdata[i].r[k]);
+    for (k=0; k<ndim; k++) rmax[k] = max(rmax[k], partdata[i].r[k]);
+  }
+  for (k=0; k<ndim; k++) length = max(length, rmax[k] - rmin[k]);
+  invlength = (length > (FLOAT) 0.0) ? (FLOAT) 1.0/length : (FLOAT) 0.0;
+
+  // Compute the key of every particle and sort (ties are broken by the old position in memory)
+  vector<pair<sfckey_t,int> > keys(Nhydro);
+#pragma omp parallel for default(none) shared(curve,invlength,keys,Nhydro,partdata,rmin)
+  for (i=0; i<Nhydro; i++) {
+    keys[i] = make_pair(ComputeSfcKey<ndim>(curve, partdata[i].r, rmin, invlength), i);
+  }
+  std::sort(keys.begin(), keys.end());
+
+  // Record the new position of each particle and re-link the periodic ghosts to their originals
+  vector<int> inew(Nhydro);
+  for (j=0; j<Nhydro; j++) inew[keys[j].second] = j;
+  for (i=Nhydro; i<Nhydro + hydro->NPeriodicGhost; i++) {
+    if (partdata[i].iorig >= 0 && partdata[i].iorig < Nhydro) {
+      partdata[i].iorig = inew[partdata[i].iorig];
+    }
+  }
+
+  // Apply the permutation in place by following each cycle until every particle is home
+  for (i=0; i<Nhydro; i++) {
+    while (inew[i] != i) {
+      j = inew[i];
+      std::swap(partdata[i], partdata[j]);
+      std::swap(inew[i], inew[j]);
+    }
+  }
 
   return;
 }
@@ -393,11 +472,6 @@ void HydroTree<ndim,ParticleType>::BuildGhostTree
   debug2("[HydroTree::BuildGhostTree]");
 
 
-  // Activate nested parallelism for tree building routines
-#ifdef _OPENMP
-  omp_set_nested(1);
-#endif
-
   if (hydro->Ntot > Ntotmax) {
 	  Ntotmax = hydro->Ntot;
 	  Ntot = hydro->Ntot;
@@ -433,10 +507,6 @@ void HydroTree<ndim,ParticleType>::BuildGhostTree
   }
   //-----------------------------------------------------------------------------------------------
 
-#ifdef _OPENMP
-  omp_set_nested(0);
-#endif
-
   return;
 }
 
@@ -593,6 +663,10 @@ void HydroTree<ndim,ParticleType>::UpdateAllStarGasForces
     int Nneibmax = Ntot; //Nneibmaxbuf[ithread];
     int Ngravcellmax = Ngravcellmaxbuf[ithread]; // ..
     FLOAT macfactor;                             // Gravity MAC factor
+    FLOAT aperiodic[ndim];                       // Periodic correction acceleration
+    FLOAT draux[ndim];                           // Relative position vector
+    FLOAT dr_corr[ndim];                         // Periodic correction vector
+    FLOAT potperiodic;                           // Periodic correction grav. potential
     int* neiblist = new int[Nneibmax];           // ..
     int* directlist = new int[Nneibmax];         // ..
     MultipoleMoment<ndim>* gravcell = new MultipoleMoment<ndim>[Ngravcellmax];   // ..
@@ -624,6 +698,15 @@ void HydroTree<ndim,ParticleType>::UpdateAllStarGasForces
           Ndirect, Ngravcell, neiblist, directlist, gravcell, partdata);
       };
 
+      // For periodic gravity, use the closest periodic replica of all distant cells
+      if (simbox.PeriodicGravity) {
+        for (int jj=0; jj<Ngravcell; jj++) {
+          for (int k=0; k<ndim; k++) draux[k] = gravcell[jj].r[k] - star->r[k];
+          NearestPeriodicVector(simbox, draux, dr_corr);
+          for (int k=0; k<ndim; k++) gravcell[jj].r[k] += dr_corr[k];
+        }
+      }
+
       // Compute contributions to star force from nearby hydro particles
       nbody->CalculateDirectHydroForces(star, Nneib, Ndirect, neiblist, directlist, hydro, simbox, ewald);
 
@@ -631,10 +714,26 @@ void HydroTree<ndim,ParticleType>::UpdateAllStarGasForces
       if (multipole == "monopole" || multipole == "fast_monopole") {
         ComputeCellMonopoleForces(star->gpot, star->a, star->r, Ngravcell, gravcell);
       }
-      else if (multipole == "quadrupole" || multipole == "fast_quadrupole") {
+      else if (multipole == "quadrupole" || multipole == "fast_quadrupole" ||
+               multipole == "fmm") {
         ComputeCellQuadrupoleForces(star->gpot, star->a, star->r, Ngravcell, gravcell);
       }
+      else if (multipole == "octupole" || multipole == "hexadecapole") {
+        ComputeCellMultipoleForces(multipole == "octupole" ? 3 : 4, star->gpot, star->a, star->r,
+                                   Ngravcell, gravcell);
+      }
 
+      // Add the periodic correction force for all cell COMs, plus the long-range force
+      // interpolated from the mesh for TreePM
+      if (simbox.PeriodicGravity) {
+        for (int jj=0; jj<Ngravcell; jj++) {
+          for (int k=0; k<ndim; k++) draux[k] = gravcell[jj].r[k] - star->r[k];
+          ewald->CalculatePeriodicCorrection(gravcell[jj].m, draux, aperiodic, potperiodic);
+          for (int k=0; k<ndim; k++) star->a[k] += aperiodic[k];
+          star->gpot += potperiodic;
+        }
+        if (ewald->pm != NULL) ewald->pm->InterpolateMeshForces(star->r, star->a, star->gpot);
+      }
 
     }
     //=============================================================================================
@@ -882,6 +981,14 @@ void HydroTree<ndim,ParticleType>::UpdateGravityExportList
           ComputeCellQuadrupoleForces(activepart[j].gpot, activepart[j].atree, activepart[j].r,
                                       gravcelllist.size(), &gravcelllist[0]);
         }
+        else if (multipole == "octupole") {
+          ComputeCellMultipoleForces(3, activepart[j].gpot, activepart[j].atree, activepart[j].r,
+                                        gravcelllist.size(), &gravcelllist[0]);
+        }
+        else if (multipole == "hexadecapole") {
+          ComputeCellMultipoleForces(4, activepart[j].gpot, activepart[j].atree, activepart[j].r,
+                                        gravcelllist.size(), &gravcelllist[0]);
+        }
 
         // Add the periodic correction force the cells
         if (simbox.PeriodicGravity){
@@ -1373,11 +1480,6 @@ void HydroTree<ndim,ParticleType>::BuildMpiGhostTree
   debug2("[HydroTree::BuildMpiGhostTree]");
 
 
-  // Activate nested parallelism for tree building routines
-#ifdef _OPENMP
-  omp_set_nested(1);
-#endif
-
 #ifdef OUTPUT_ALL
   cout << "BUILDING TREE WITH " << hydro->Nmpighost << " MPI GHOSTS!!" << endl;
 #endif
@@ -1417,10 +1519,6 @@ void HydroTree<ndim,ParticleType>::BuildMpiGhostTree
   }
   //-----------------------------------------------------------------------------------------------
 
-#ifdef _OPENMP
-  omp_set_nested(0);
-#endif
-
 
   return;
 }
@@ -125,8 +125,9 @@ void KDRadiationTree<ndim,nfreq,ParticleType,CellType>::DeallocateMemory(void)
 //=================================================================================================
 //  KDRadiationTree::BuildTree
 /// Call all routines to build/re-build the KD-tree on the local node.
-/// If OpenMP is activated, the local domain is partitioned into sub-trees
-/// in order to improve the scalability of building and stocking the tree.
+/// If OpenMP is activated, the sub-trees of all large cells are built as separate tasks by the
+/// threads of a single parallel region in order to improve the scalability of building and
+/// stocking the tree.
 //=================================================================================================
 template <int ndim, int nfreq, template<int> class ParticleType, template<int,int> class CellType>
 void KDRadiationTree<ndim,nfreq,ParticleType,CellType>::BuildTree
@@ -144,11 +145,6 @@ void KDRadiationTree<ndim,nfreq,ParticleType,CellType>::BuildTree
 
   cout << "Building tree with " << Npart << " particles" << endl;
 
-  // Activate nested parallelism for tree building routines
-#ifdef _OPENMP
-  omp_set_nested(1);
-#endif
-
   // Set no. of tree members to total number of SPH particles (inc. ghosts)
   ltot_old   = ltot;
   Ntotold    = Ntot;
@@ -199,7 +195,11 @@ void KDRadiationTree<ndim,nfreq,ParticleType,CellType>::BuildTree
     }
 
     // Recursively build tree from root node down
-    DivideTreeCell(0,Ntot-1,partdata,radcell[0]);
+#pragma omp parallel default(none) shared(partdata)
+    {
+#pragma omp single
+      DivideTreeCell(0,Ntot-1,partdata,radcell[0]);
+    }
 
     // Calculate more optimal cell quantities for speeding up ray walking on tree
     OptimiseTree();
@@ -326,7 +326,6 @@ void KDRadiationTree<ndim,nfreq,ParticleType,CellType>::DivideTreeCell
   ParticleType<ndim> *partdata,        ///< [in] Pointer to main SPH object
   CellType<ndim,nfreq> &cell)          ///< [inout] Cell to be divided
 {
-  int i;                               // Aux. child cell counter
   int j;                               // Aux. particle counter
   int k;                               // Dimension counter
   int k_divide = 0;                    // Division dimension
@@ -407,31 +406,12 @@ void KDRadiationTree<ndim,nfreq,ParticleType,CellType>::DivideTreeCell
   }
 
 
-  // Now divide the new child cells as a recursive function
-#if defined _OPENMP
-  if (pow(2,cell.level) < Nthreads) {
-#pragma omp parallel default(none) private(i) shared(cell,ifirst,ilast,partdata) num_threads(2)
-    {
-#pragma omp for
-      for (i=0; i<2; i++) {
-        if (i == 0) DivideTreeCell(ifirst,ifirst+cell.N/2-1,partdata,radcell[cell.c1]);
-        else if (i == 1) DivideTreeCell(ifirst+cell.N/2,ilast,partdata,radcell[cell.c2]);
-      }
-#pragma omp barrier
-    }
-  }
-  else {
-    for (i=0; i<2; i++) {
-      if (i == 0) DivideTreeCell(ifirst,ifirst+cell.N/2-1,partdata,radcell[cell.c1]);
-      else if (i == 1) DivideTreeCell(ifirst+cell.N/2,ilast,partdata,radcell[cell.c2]);
-    }
-  }
-#else
-  for (i=0; i<2; i++) {
-    if (i == 0) DivideTreeCell(ifirst,ifirst+cell.N/2-1,partdata,radcell[cell.c1]);
-    else if (i == 1) DivideTreeCell(ifirst+cell.N/2,ilast,partdata,radcell[cell.c2]);
-  }
-#endif
+  // Now divide the new child cells as a recursive function.  The first child of a large cell
+  // is divided as a separate task (which may be picked up by any idle thread of the team).
+#pragma omp task default(none) shared(cell,ifirst,partdata) if(cell.N >= Ntaskmin)
+  DivideTreeCell(ifirst,ifirst+cell.N/2-1,partdata,radcell[cell.c1]);
+  DivideTreeCell(ifirst+cell.N/2,ilast,partdata,radcell[cell.c2]);
+#pragma omp taskwait
 
 
   // Re-set the cell first and last particles now that child cells have been
@@ -550,24 +530,12 @@ void KDRadiationTree<ndim,nfreq,ParticleType,CellType>::StockTree
  ParticleType<ndim> *partdata,      ///< SPH particle data array
  bool stock_leaf)					///< Whether or not to stock leaf cells
 {
-  int i;                            // Aux. child cell counter
-
-  // If cell is not leaf, stock child cells
+  // If cell is not leaf, stock child cells (the first child of a large cell as a separate task)
   if (cell.level != ltot) {
-    if (pow(2,cell.level) < Nthreads) {
-#pragma omp parallel for default(none) private(i) shared(cell,partdata,stock_leaf) num_threads(2)
-      for (i=0; i<2; i++) {
-        if (i == 0) StockTree(radcell[cell.c1],partdata,stock_leaf);
-        else if (i == 1) StockTree(radcell[cell.c2],partdata,stock_leaf);
-      }
-#pragma omp barrier
-    }
-    else {
-      for (i=0; i<2; i++) {
-        if (i == 0) StockTree(radcell[cell.c1],partdata,stock_leaf);
-        else if (i == 1) StockTree(radcell[cell.c2],partdata,stock_leaf);
-      }
-    }
+#pragma omp task default(none) shared(cell,partdata,stock_leaf) if(cell.N >= Ntaskmin)
+    StockTree(radcell[cell.c1],partdata,stock_leaf);
+    StockTree(radcell[cell.c2],partdata,stock_leaf);
+#pragma omp taskwait
   }
 
   // Stock node once all children are stocked
@@ -1029,32 +997,14 @@ void KDRadiationTree<ndim,nfreq,ParticleType,CellType>::SumRadiationField
  (const int level,                     ///< [in] maximum level to sum radiation field to
   CellType<ndim,nfreq> &cell)          ///< [inout] KD radiation tree cell pointer
 {
-  int i;                               // Particle counter
   int k;                               // Dimension counter
 
-  // If cell is not leaf, stock child cells
+  // If cell is not leaf, sum child cells (the first child of a large cell as a separate task)
   if (cell.level != level) {
-#if defined _OPENMP
-    if (pow(2,cell.level) < Nthreads) {
-#pragma omp parallel for default(none) private(i) shared(cell) num_threads(2)
-      for (i=0; i<2; i++) {
-        if (i == 0) SumRadiationField(level,radcell[cell.c1]);
-        else if (i == 1) SumRadiationField(level,radcell[cell.c2]);
-      }
-#pragma omp barrier
-    }
-    else {
-      for (i=0; i<2; i++) {
-        if (i == 0) SumRadiationField(level,radcell[cell.c1]);
-        else if (i == 1) SumRadiationField(level,radcell[cell.c2]);
-      }
-    }
-#else
-    for (i=0; i<2; i++) {
-      if (i == 0) SumRadiationField(level,radcell[cell.c1]);
-      else if (i == 1) SumRadiationField(level,radcell[cell.c2]);
-    }
-#endif
+#pragma omp task default(none) shared(cell,level) if(cell.N >= Ntaskmin)
+    SumRadiationField(level,radcell[cell.c1]);
+    SumRadiationField(level,radcell[cell.c2]);
+#pragma omp taskwait
   }
 
 
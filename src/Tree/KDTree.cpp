@@ -213,8 +213,9 @@ void KDTree<ndim,ParticleType,TreeCell>::DeallocateTreeMemory(void)
 //=================================================================================================
 //  KDTree::BuildTree
 /// Call all routines to build/re-build the KD-tree on the local node.
-/// If OpenMP is activated, the local domain is partitioned into sub-trees
-/// in order to improve the scalability of building and stocking the tree.
+/// If OpenMP is activated, the sub-trees of all large cells are built as separate tasks by the
+/// threads of a single parallel region in order to improve the scalability of building and
+/// stocking the tree.
 //=================================================================================================
 template <int ndim, template<int> class ParticleType, template<int> class TreeCell>
 void KDTree<ndim,ParticleType,TreeCell>::BuildTree
@@ -235,11 +236,6 @@ void KDTree<ndim,ParticleType,TreeCell>::BuildTree
 
   ParticleType<ndim>* partdata = reinterpret_cast<ParticleType<ndim>*>(part_gen) ;
 
-  // Activate nested parallelism for tree building routines
-#ifdef _OPENMP
-  omp_set_nested(1);
-#endif
-
   // Set no. of tree members to total number of SPH particles (inc. ghosts)
   gtot = 0;
   ltot_old = ltot;
@@ -303,7 +299,11 @@ void KDTree<ndim,ParticleType,TreeCell>::BuildTree
 
   // If there are particles in the tree, recursively build tree from root node down
   if (Ntot > 0) {
-    DivideTreeCell(ifirst, ilast, partdata, celldata[0]);
+#pragma omp parallel default(none) shared(partdata)
+    {
+#pragma omp single
+      DivideTreeCell(ifirst, ilast, partdata, celldata[0]);
+    }
 #if defined(VERIFY_ALL)
     ValidateTree(partdata);
 #endif
@@ -496,13 +496,20 @@ void KDTree<ndim,ParticleType,TreeCell>::DivideTreeCell
       //cout << "Division? : " << k_divide << "    " << rkmax << endl;
     }
   }
-  //cell.k_divide = k_divide;
+  cell.k_divide = k_divide;
   //cin >> i;
 
 
   // Find median value along selected division plane and re-order array
-  // so particles reside on correct side of division
-  rdivide = QuickSelect(cell.ifirst, cell.ilast, cell.ifirst+cell.N/2, k_divide, partdata);
+  // so particles reside on correct side of division.  Near the root there are too few
+  // sub-trees to keep all threads busy, so the partitioning itself is done in parallel.
+  if (cell.N >= Ntaskmin && pow(2,cell.level) < Nthreads) {
+    rdivide = QuickSelectParallel(cell.ifirst, cell.ilast, cell.ifirst+cell.N/2, k_divide, partdata);
+  }
+  else {
+    rdivide = QuickSelect(cell.ifirst, cell.ilast, cell.ifirst+cell.N/2, k_divide, partdata);
+  }
+  cell.r_divide = rdivide;
 
   // Set properties of first child cell
   for (k=0; k<ndim; k++) celldata[cell.c1].bb.min[k] = cell.bb.min[k];
@@ -546,31 +553,12 @@ void KDTree<ndim,ParticleType,TreeCell>::DivideTreeCell
   }*/
 
 
-  // Now divide the new child cells as a recursive function
-#if defined _OPENMP
-  if (pow(2,cell.level) < Nthreads) {
-#pragma omp parallel default(none) private(i) shared(cell,ifirst,ilast,partdata) num_threads(2)
-    {
-#pragma omp for
-      for (i=0; i<2; i++) {
-        if (i == 0) DivideTreeCell(ifirst,ifirst+cell.N/2-1,partdata,celldata[cell.c1]);
-        else if (i == 1) DivideTreeCell(ifirst+cell.N/2,ilast,partdata,celldata[cell.c2]);
-      }
-#pragma omp barrier
-    }
-  }
-  else {
-    for (i=0; i<2; i++) {
-      if (i == 0) DivideTreeCell(ifirst,ifirst+cell.N/2-1,partdata,celldata[cell.c1]);
-      else if (i == 1) DivideTreeCell(ifirst+cell.N/2,ilast,partdata,celldata[cell.c2]);
-    }
-  }
-#else
-  for (i=0; i<2; i++) {
-    if (i == 0) DivideTreeCell(ifirst,ifirst+cell.N/2-1,partdata,celldata[cell.c1]);
-    else if (i == 1) DivideTreeCell(ifirst+cell.N/2,ilast,partdata,celldata[cell.c2]);
-  }
-#endif
+  // Now divide the new child cells as a recursive function.  The first child of a large cell
+  // is divided as a separate task (which may be picked up by any idle thread of the team).
+#pragma omp task default(none) shared(cell,ifirst,partdata) if(cell.N >= Ntaskmin)
+  DivideTreeCell(ifirst,ifirst+cell.N/2-1,partdata,celldata[cell.c1]);
+  DivideTreeCell(ifirst+cell.N/2,ilast,partdata,celldata[cell.c2]);
+#pragma omp taskwait
 
 
   // Re-set the cell first and last particles now that child cells have been
@@ -591,6 +579,180 @@ void KDTree<ndim,ParticleType,TreeCell>::DivideTreeCell
   // Stock all cell properties once constructed
   StockCellProperties(cell,partdata,true);
 
+  // Record the volume of the bounding box for the incremental refit
+  cell.bbvol = (FLOAT) 1.0;
+  for (k=0; k<ndim; k++) cell.bbvol *= cell.bb.max[k] - cell.bb.min[k];
+
+  return;
+}
+
+
+
+//=================================================================================================
+//  KDTree::RefitTree
+/// Incrementally refit the tree to the new particle positions instead of a full re-build.
+/// All particles are first moved into the leaf cell that contains their new position, using the
+/// division planes of the existing tree, and the id array is re-ordered so that each cell again
+/// holds a contiguous range of ids.  Any cell whose occupancy or bounding-box volume has drifted
+/// by more than the given tolerance is then re-divided from scratch, and all other cells are
+/// simply re-stocked (see RefitTreeCell).
+//=================================================================================================
+template <int ndim, template<int> class ParticleType, template<int> class TreeCell>
+void KDTree<ndim,ParticleType,TreeCell>::RefitTree
+ (Particle<ndim> *part_gen,            ///< [in] Particle data array
+  const FLOAT refittol)                ///< [in] Tolerance for re-dividing cells
+{
+  int c;                               // Cell counter
+  int i;                               // Particle counter
+  int *inew;                           // Position of next particle of each cell in id array
+  int *leafcell;                       // Leaf cell containing each particle
+  ParticleType<ndim>* partdata = reinterpret_cast<ParticleType<ndim>*>(part_gen);
+
+  debug2("[KDTree::RefitTree]");
+
+  if (Ntot == 0 || ifirst == -1) return;
+
+  inew     = new int[Ncell];
+  leafcell = new int[ilast + 1];
+
+  // Find the leaf cell containing each particle by walking down the division planes
+#pragma omp parallel for default(none) private(c) shared(leafcell,partdata)
+  for (i=ifirst; i<=ilast; i++) {
+    c = 0;
+    while (celldata[c].level != ltot) {
+      if (partdata[i].r[celldata[c].k_divide] < celldata[c].r_divide) c = celldata[c].c1;
+      else c = celldata[c].c2;
+    }
+    leafcell[i] = c;
+  }
+
+  // Count the particles in each cell (child cells always have larger ids than their parent)
+  for (c=0; c<Ncell; c++) celldata[c].N = 0;
+  for (i=ifirst; i<=ilast; i++) celldata[leafcell[i]].N++;
+  for (c=Ncell-1; c>=0; c--) {
+    if (celldata[c].level != ltot) {
+      celldata[c].N = celldata[celldata[c].c1].N + celldata[celldata[c].c2].N;
+    }
+  }
+
+  // Set the range of each cell in the id array and sort the ids into their new leaf cells
+  celldata[0].ifirst = ifirst;
+  celldata[0].ilast  = ilast;
+  for (c=0; c<Ncell; c++) {
+    TreeCell<ndim> &cell = celldata[c];
+    if (cell.level != ltot) {
+      celldata[cell.c1].ifirst = cell.ifirst;
+      celldata[cell.c1].ilast  = cell.ifirst + celldata[cell.c1].N - 1;
+      celldata[cell.c2].ifirst = cell.ifirst + celldata[cell.c1].N;
+      celldata[cell.c2].ilast  = cell.ilast;
+    }
+    inew[c] = cell.ifirst;
+  }
+  for (i=ifirst; i<=ilast; i++) ids[inew[leafcell[i]]++] = i;
+
+  // Now refit (or re-divide) all cells recursively from the root cell down
+#pragma omp parallel default(none) shared(partdata,refittol)
+  {
+#pragma omp single
+    RefitTreeCell(partdata, celldata[0], refittol);
+  }
+#if defined(VERIFY_ALL)
+  ValidateTree(partdata);
+#endif
+
+  delete[] leafcell;
+  delete[] inew;
+
+  return;
+}
+
+
+
+//=================================================================================================
+//  KDTree::RefitTreeCell
+/// Recursive routine to refit a tree cell once the particles have been moved into their new leaf
+/// cells.  If either child cell would contain a leaf cell with more than Nleafmax particles, or
+/// the numbers of particles in the two child cells differ by more than the fraction
+/// 'refittol' of the cell's particles, or the volume of the cell's bounding box has grown by
+/// more than a factor (1 + refittol)^ndim since it was last divided, then the whole sub-tree is
+/// re-divided with DivideTreeCell.  Otherwise the child cells are refitted and the linked lists
+/// are joined and stocked as in DivideTreeCell.
+//=================================================================================================
+template <int ndim, template<int> class ParticleType, template<int> class TreeCell>
+void KDTree<ndim,ParticleType,TreeCell>::RefitTreeCell
+ (ParticleType<ndim> *partdata,        ///< [in] Particle data array
+  TreeCell<ndim> &cell,                ///< [inout] Cell to be refitted
+  const FLOAT refittol)                ///< [in] Tolerance for re-dividing cells
+{
+  int i;                               // Particle id
+  int j;                               // Aux. particle counter
+  int k;                               // Dimension counter
+
+
+  // If cell is a leaf cell, set linked lists from the (re-ordered) id array
+  if (cell.level == ltot) {
+#ifdef MPI_PARALLEL
+    cell.worktot = 0.0;
+#endif
+    if (cell.N > 0) {
+      for (j=cell.ifirst; j<cell.ilast; j++) inext[ids[j]] = ids[j+1];
+      cell.ifirst = ids[cell.ifirst];
+      cell.ilast  = ids[cell.ilast];
+    }
+    else {
+      cell.ifirst = -1;
+      cell.ilast  = -1;
+    }
+    StockCellProperties(cell,partdata,true);
+    return;
+  }
+
+  // Check if either child cell can no longer hold its particles in leaf cells of at most
+  // Nleafmax particles, or if the occupancy or the volume of the cell has drifted past the
+  // tolerance
+  const int Nchildmax = Nleafmax << (ltot - cell.level - 1);
+  bool redivide = (celldata[cell.c1].N > Nchildmax || celldata[cell.c2].N > Nchildmax);
+  if (cell.N > 0) {
+    FLOAT bbvol = (FLOAT) 1.0;
+    for (k=0; k<ndim; k++) bbvol *= cell.bb.max[k] - cell.bb.min[k];
+    if (abs(celldata[cell.c1].N - celldata[cell.c2].N) > refittol*(FLOAT) cell.N) redivide = true;
+    if (cell.bbvol > (FLOAT) 0.0 && bbvol > pow((FLOAT) 1.0 + refittol, ndim)*cell.bbvol) {
+      redivide = true;
+    }
+  }
+
+  // Re-divide the whole sub-tree, using the bounding box of the new particle positions
+  if (redivide) {
+    for (k=0; k<ndim; k++) cell.bb.min[k] = big_number;
+    for (k=0; k<ndim; k++) cell.bb.max[k] = -big_number;
+    for (j=cell.ifirst; j<=cell.ilast; j++) {
+      i = ids[j];
+      for (k=0; k<ndim; k++) cell.bb.min[k] = min(cell.bb.min[k], partdata[i].r[k]);
+      for (k=0; k<ndim; k++) cell.bb.max[k] = max(cell.bb.max[k], partdata[i].r[k]);
+    }
+    DivideTreeCell(cell.ifirst, cell.ilast, partdata, cell);
+    return;
+  }
+
+  // Otherwise refit both child cells (the first child of a large cell as a separate task)
+#pragma omp task default(none) shared(cell,partdata,refittol) if(cell.N >= Ntaskmin)
+  RefitTreeCell(partdata, celldata[cell.c1], refittol);
+  RefitTreeCell(partdata, celldata[cell.c2], refittol);
+#pragma omp taskwait
+
+  // Join the linked lists of the two child cells
+  if (celldata[cell.c1].N > 0) {
+    cell.ifirst = celldata[cell.c1].ifirst;
+    inext[celldata[cell.c1].ilast] = celldata[cell.c2].ifirst;
+    cell.ilast = (celldata[cell.c2].N > 0) ? celldata[cell.c2].ilast : celldata[cell.c1].ilast;
+  }
+  else {
+    cell.ifirst = celldata[cell.c2].ifirst;
+    cell.ilast  = celldata[cell.c2].ilast;
+  }
+
+  StockCellProperties(cell,partdata,true);
+
   return;
 }
 
@@ -751,6 +913,123 @@ FLOAT KDTree<ndim,ParticleType,TreeCell>::QuickSelect
 
 
 
+//=================================================================================================
+//  KDTree::QuickSelectParallel
+/// Parallel version of QuickSelect for large cells near the root of the tree.  Each iteration
+/// splits the particles into those below, equal to and above the pivot value in three stages
+/// (counting, scattering into an auxilary array and copying back), with each stage divided into
+/// one OpenMP task per thread.  Once the remaining range is small, the serial QuickSelect is
+/// used to find the median.
+//=================================================================================================
+template <int ndim, template<int> class ParticleType, template<int> class TreeCell>
+FLOAT KDTree<ndim,ParticleType,TreeCell>::QuickSelectParallel
+ (int left,                            ///< Left-most id of particle in array
+  int right,                           ///< Right-most id of particle in array
+  int jpivot,                          ///< Pivot/median point
+  int k,                               ///< Dimension of sort
+  ParticleType<ndim> *partdata)        ///< Pointer to main SPH object
+{
+  const int Nchunk = Nthreads;         // No. of tasks for each stage
+  int c;                               // Chunk counter
+  int *idsaux = new int[right - left + 1];        // Auxilary id array
+  vector<int> Nbelow(Nchunk);          // No. of particles below pivot in each chunk
+  vector<int> Nequal(Nchunk);          // No. of particles equal to pivot in each chunk
+  vector<int> jbelow(Nchunk);          // Position of first particle below pivot in each chunk
+  vector<int> jequal(Nchunk);          // Position of first particle equal to pivot  "      "
+  vector<int> jabove(Nchunk);          // Position of first particle above pivot   "      "
+  FLOAT rpivot = (FLOAT) 0.0;          // Value of pivot
+
+
+  //-----------------------------------------------------------------------------------------------
+  while (right - left + 1 >= Ntaskmin) {
+    const int Nrange = right - left + 1;
+    const int Nsize  = (Nrange + Nchunk - 1)/Nchunk;
+    rpivot = partdata[ids[(left + right)/2]].r[k];
+
+    // Count the particles below and equal to the pivot in each chunk
+    for (c=0; c<Nchunk; c++) {
+#pragma omp task default(none) firstprivate(c) shared(Nbelow,Nequal,Nsize,k,left,partdata,right,rpivot)
+      {
+        const int jstart = left + c*Nsize;
+        const int jend   = min(jstart + Nsize, right + 1);
+        Nbelow[c] = 0;
+        Nequal[c] = 0;
+        for (int j=jstart; j<jend; j++) {
+          if (partdata[ids[j]].r[k] < rpivot) Nbelow[c]++;
+          else if (partdata[ids[j]].r[k] == rpivot) Nequal[c]++;
+        }
+      }
+    }
+#pragma omp taskwait
+
+    // Compute the positions of each chunk's particles in the partitioned array
+    int Nbelowtot = 0;
+    int Nequaltot = 0;
+    for (c=0; c<Nchunk; c++) {
+      Nbelowtot += Nbelow[c];
+      Nequaltot += Nequal[c];
+    }
+    jbelow[0] = 0;
+    jequal[0] = Nbelowtot;
+    jabove[0] = Nbelowtot + Nequaltot;
+    for (c=1; c<Nchunk; c++) {
+      const int Nprev = max(min(Nsize, Nrange - (c - 1)*Nsize), 0);
+      jbelow[c] = jbelow[c-1] + Nbelow[c-1];
+      jequal[c] = jequal[c-1] + Nequal[c-1];
+      jabove[c] = jabove[c-1] + Nprev - Nbelow[c-1] - Nequal[c-1];
+    }
+
+    // Scatter the ids into the auxilary array and then copy back to the main array
+    for (c=0; c<Nchunk; c++) {
+#pragma omp task default(none) firstprivate(c) \
+  shared(idsaux,jabove,jbelow,jequal,Nsize,k,left,partdata,right,rpivot)
+      {
+        const int jstart = left + c*Nsize;
+        const int jend   = min(jstart + Nsize, right + 1);
+        int jb = jbelow[c];
+        int je = jequal[c];
+        int ja = jabove[c];
+        for (int j=jstart; j<jend; j++) {
+          if (partdata[ids[j]].r[k] < rpivot) idsaux[jb++] = ids[j];
+          else if (partdata[ids[j]].r[k] == rpivot) idsaux[je++] = ids[j];
+          else idsaux[ja++] = ids[j];
+        }
+      }
+    }
+#pragma omp taskwait
+    for (c=0; c<Nchunk; c++) {
+#pragma omp task default(none) firstprivate(c) shared(idsaux,Nsize,left,right)
+      {
+        const int jstart = left + c*Nsize;
+        const int jend   = min(jstart + Nsize, right + 1);
+        for (int j=jstart; j<jend; j++) ids[j] = idsaux[j - left];
+      }
+    }
+#pragma omp taskwait
+
+    // Continue with the part of the array containing the median, unless the median is equal
+    // to the pivot value
+    if (jpivot < left + Nbelowtot) {
+      right = left + Nbelowtot - 1;
+    }
+    else if (jpivot >= left + Nbelowtot + Nequaltot) {
+      left = left + Nbelowtot + Nequaltot;
+    }
+    else {
+      delete[] idsaux;
+      return rpivot;
+    }
+
+  };
+  //-----------------------------------------------------------------------------------------------
+
+  delete[] idsaux;
+
+  return QuickSelect(left, right, jpivot, k, partdata);
+}
+
+
+
 //=================================================================================================
 //  KDTree::StockTree
 /// Stock given tree cell in KD-tree.  If cell is not a leaf-cell, recursively
@@ -762,33 +1041,14 @@ void KDTree<ndim,ParticleType,TreeCell>::StockTree
  ParticleType<ndim> *partdata,        ///< SPH particle data array
  bool stock_leaf)					  ///< Whether to stock leaf cells
 {
-  int i;                               // Aux. child cell counter
-
-  // If cell is not leaf, stock child cells
+  // If cell is not leaf, stock child cells (the first child of a large cell as a separate task)
   if (cell.copen != -1) {
-	  TreeCell<ndim>& child1 = celldata[cell.copen];
-	  TreeCell<ndim>& child2 = celldata[child1.cnext];
-#if defined _OPENMP
-    if (pow(2,cell.level) < Nthreads) {
-#pragma omp parallel for default(none) private(i) shared(cell,partdata, stock_leaf,child1,child2) num_threads(2)
-      for (i=0; i<2; i++) {
-        if (i == 0) StockTree(child1,partdata, stock_leaf);
-        else if (i == 1) StockTree(child2,partdata, stock_leaf);
-      }
-#pragma omp barrier
-    }
-    else {
-      for (i=0; i<2; i++) {
-        if (i == 0) StockTree(child1,partdata, stock_leaf);
-        else if (i == 1) StockTree(child2,partdata, stock_leaf);
-      }
-    }
-#else
-    for (i=0; i<2; i++) {
-      if (i == 0) StockTree(child1,partdata, stock_leaf);
-      else if (i == 1) StockTree(child2,partdata, stock_leaf);
-    }
-#endif
+    TreeCell<ndim>& child1 = celldata[cell.copen];
+    TreeCell<ndim>& child2 = celldata[child1.cnext];
+#pragma omp task default(none) shared(child1,partdata,stock_leaf) if(cell.N >= Ntaskmin)
+    StockTree(child1,partdata,stock_leaf);
+    StockTree(child2,partdata,stock_leaf);
+#pragma omp taskwait
   }
 
   // Stock node once all children are stocked
@@ -820,8 +1080,11 @@ void KDTree<ndim,ParticleType,TreeCell>::StockCellProperties
   FLOAT lambda = (FLOAT) 0.0;          // ..
 
 
+  const int multipole_order =
+      (multipole == "hexadecapole") ? 4 : ((multipole == "octupole") ? 3 : 2);
   const bool need_quadrupole_moments =
-      multipole == "quadrupole" || multipole == "fast_quadrupole" || gravity_mac == eigenmac ;
+      multipole == "quadrupole" || multipole == "fast_quadrupole" || multipole == "fmm" ||
+      multipole_order > 2 || gravity_mac == eigenmac ;
 
   // Zero all summation variables for all cells
   if ((cell.level==ltot&&stock_leaf) || cell.copen != -1 ) {
@@ -840,6 +1103,11 @@ void KDTree<ndim,ParticleType,TreeCell>::StockCellProperties
       else if (gravity_mac == eigenmac)
         cell.macfactor = 0 ;
       for (k=0; k<5; k++) cell.q[k]          = (FLOAT) 0.0;
+      if (multipole_order > 2) {
+        cell.qtrace = (FLOAT) 0.0;
+        for (k=0; k<Noctupole; k++) cell.q3[k]     = (FLOAT) 0.0;
+        for (k=0; k<Nhexadecapole; k++) cell.q4[k] = (FLOAT) 0.0;
+      }
 	  for (k=0; k<ndim; k++) cell.r[k]       = (FLOAT) 0.0;
 	  for (k=0; k<ndim; k++) cell.v[k]       = (FLOAT) 0.0;
 	  for (k=0; k<ndim; k++) cell.rcell[k]   = (FLOAT) 0.0;
@@ -941,6 +1209,7 @@ void KDTree<ndim,ParticleType,TreeCell>::StockCellProperties
           } else if (ndim == 1) {
             cell.q[0] += mi*((FLOAT) 3.0*dr[0]*dr[0] - drsqd);
           }
+          if (multipole_order > 2) AddParticleHigherMoments(cell, mi, dr, multipole_order);
         }
         if (i == cell.ilast) break;
         i = inext[i];
@@ -1024,6 +1293,7 @@ void KDTree<ndim,ParticleType,TreeCell>::StockCellProperties
         cell.q[0] += child1.q[0] ;
         cell.q[0] += mi*((FLOAT) 3.0*dr[0]*dr[0] - drsqd);
       }
+      if (multipole_order > 2) AddChildHigherMoments(cell, child1, multipole_order);
     }
 
     if (need_quadrupole_moments && child2.m > 0) {
@@ -1048,6 +1318,7 @@ void KDTree<ndim,ParticleType,TreeCell>::StockCellProperties
         cell.q[0] += child2.q[0] ;
         cell.q[0] += mi*((FLOAT) 3.0*dr[0]*dr[0] - drsqd);
       }
+      if (multipole_order > 2) AddChildHigherMoments(cell, child2, multipole_order);
     }
 
   }
@@ -1133,28 +1404,12 @@ void KDTree<ndim,ParticleType,TreeCell>::UpdateHmaxValues
   int i;                               // Particle counter
   int k;                               // Dimension counter
 
-  // If cell is not leaf, stock child cells
+  // If cell is not leaf, stock child cells (the first child of a large cell as a separate task)
   if (cell.level != ltot) {
-#if defined _OPENMP
-    if (pow(2,cell.level) < Nthreads) {
-#pragma omp parallel for default(none) private(i) shared(cell,partdata) num_threads(2)
-      for (i=0; i<2; i++) {
-        if (i == 0) UpdateHmaxValues(celldata[cell.c1],partdata);
-        else if (i == 1) UpdateHmaxValues(celldata[cell.c2],partdata);
-      }
-    }
-    else {
-      for (i=0; i<2; i++) {
-        if (i == 0) UpdateHmaxValues(celldata[cell.c1],partdata);
-        else if (i == 1) UpdateHmaxValues(celldata[cell.c2],partdata);
-      }
-    }
-#else
-    for (i=0; i<2; i++) {
-      if (i == 0) UpdateHmaxValues(celldata[cell.c1],partdata);
-      else if (i == 1) UpdateHmaxValues(celldata[cell.c2],partdata);
-    }
-#endif
+#pragma omp task default(none) shared(cell,partdata) if(cell.N >= Ntaskmin)
+    UpdateHmaxValues(celldata[cell.c1],partdata);
+    UpdateHmaxValues(celldata[cell.c2],partdata);
+#pragma omp taskwait
   }
 
 
@@ -1266,31 +1521,14 @@ void KDTree<ndim,ParticleType,TreeCell>::UpdateWorkCounters
  (TreeCell<ndim> &cell)                ///< KD-tree cell
 {
   int cc,ccc;                          // Cell counters
-  int i;                               // Particle counter
 
   // If cell is not leaf, stock child cells
   //-----------------------------------------------------------------------------------------------
   if (cell.level != ltot && cell.c1 >= 0) {
-#if defined _OPENMP
-    if (pow(2,cell.level) < Nthreads) {
-#pragma omp parallel for default(none) private(i) shared(cell) num_threads(2)
-      for (i=0; i<2; i++) {
-        if (i == 0) UpdateWorkCounters(celldata[cell.c1]);
-        else if (i == 1) UpdateWorkCounters(celldata[cell.c2]);
-      }
-    }
-    else {
-      for (i=0; i<2; i++) {
-        if (i == 0) UpdateWorkCounters(celldata[cell.c1]);
-        else if (i == 1) UpdateWorkCounters(celldata[cell.c2]);
-      }
-    }
-#else
-    for (i=0; i<2; i++) {
-      if (i == 0) UpdateWorkCounters(celldata[cell.c1]);
-      else if (i == 1) UpdateWorkCounters(celldata[cell.c2]);
-    }
-#endif
+#pragma omp task default(none) shared(cell) if(cell.N >= Ntaskmin)
+    UpdateWorkCounters(celldata[cell.c1]);
+    UpdateWorkCounters(celldata[cell.c2]);
+#pragma omp taskwait
   }
   //-----------------------------------------------------------------------------------------------
 
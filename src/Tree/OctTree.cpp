@@ -305,8 +305,11 @@ void OctTree<ndim,ParticleType,TreeCell>::BuildTree
       cellSize *= (FLOAT) 0.5;
 
 
-      // Loop over all unfinished cells to find new child cell occupancy
+      // Loop over all unfinished cells to find new child cell occupancy.  Each cell only writes
+      // to its own children cells and particles, so all cells on the level are divided in parallel.
       //-------------------------------------------------------------------------------------------
+#pragma omp parallel for default(none) schedule(guided) private(c,ckid,cnew,i,ilast,k,kk) \
+  shared(cellSize,celllist,Nlist,partdata)
       for (cc=0; cc<Nlist; cc++) {
         c = celllist[cc];
         TreeCell<ndim> &cell = celldata[c];
@@ -471,16 +474,21 @@ void OctTree<ndim,ParticleType,TreeCell>::StockTree
 
   debug2("[OctTree::StockTree]");
 
+  const int multipole_order =
+      (multipole == "hexadecapole") ? 4 : ((multipole == "octupole") ? 3 : 2);
   const bool need_quadrupole_moments =
-      multipole == "quadrupole" || multipole == "fast_quadrupole" || gravity_mac == eigenmac ;
+      multipole == "quadrupole" || multipole == "fast_quadrupole" || multipole == "fmm" ||
+      multipole_order > 2 || gravity_mac == eigenmac ;
 
   // Loop over all levels in tree starting from lowest up to the top root cell level.
   //===============================================================================================
   for (l=ltot; l>=0; l--) {
 
 
-    // Loop over all cells on current level
+    // Loop over all cells on current level (which only depend on cells on lower levels)
     //---------------------------------------------------------------------------------------------
+#pragma omp parallel for default(none) schedule(guided) \
+  private(cc,cend,dr,drsqd,i,iaux,k,lambda,mi,p) shared(l,multipole_order,need_quadrupole_moments,partdata,stock_leaf)
     for (c=firstCell[l]; c<=lastCell[l]; c++) {
       TreeCell<ndim> &cell = celldata[c];
 
@@ -507,6 +515,11 @@ void OctTree<ndim,ParticleType,TreeCell>::StockTree
       for (k=0; k<ndim; k++) cell.hbox.min[k] = big_number;
       for (k=0; k<ndim; k++) cell.hbox.max[k] = -big_number;
       for (k=0; k<5; k++) cell.q[k] = (FLOAT) 0.0;
+      if (multipole_order > 2) {
+        cell.qtrace = (FLOAT) 0.0;
+        for (k=0; k<Noctupole; k++) cell.q3[k] = (FLOAT) 0.0;
+        for (k=0; k<Nhexadecapole; k++) cell.q4[k] = (FLOAT) 0.0;
+      }
 
 
       // If this is a leaf cell, sum over all particles
@@ -599,6 +612,7 @@ void OctTree<ndim,ParticleType,TreeCell>::StockTree
               else if (ndim == 1) {
                 cell.q[0] += mi*((FLOAT) 3.0*dr[0]*dr[0] - drsqd);
               }
+              if (multipole_order > 2) AddParticleHigherMoments(cell, mi, dr, multipole_order);
             }
             if (i == cell.ilast) break;
             i = inext[i];
@@ -681,6 +695,7 @@ void OctTree<ndim,ParticleType,TreeCell>::StockTree
               cell.q[0] += child.q[0] ;
               cell.q[0] += mi*((FLOAT) 3.0*dr[0]*dr[0] - drsqd);
             }
+            if (multipole_order > 2) AddChildHigherMoments(cell, child, multipole_order);
           }
 
           cc = child.cnext;
@@ -749,8 +764,9 @@ void OctTree<ndim,ParticleType,TreeCell>::UpdateHmaxValues
   for (l=ltot; l>=0; l--) {
 
 
-    // Loop over all cells on current level
+    // Loop over all cells on current level (which only depend on cells on lower levels)
     //---------------------------------------------------------------------------------------------
+#pragma omp parallel for default(none) schedule(guided) private(cc,cend,cfirst,i,k) shared(l,partdata)
     for (c=firstCell[l]; c<=lastCell[l]; c++) {
       TreeCell<ndim> &cell = celldata[c];
 
@@ -878,8 +894,9 @@ void OctTree<ndim,ParticleType,TreeCell>::UpdateWorkCounters
   for (l=ltot; l>=0; l--) {
 
 
-    // Loop over all cells on current level
+    // Loop over all cells on current level (which only depend on cells on lower levels)
     //---------------------------------------------------------------------------------------------
+#pragma omp parallel for default(none) schedule(guided) private(cc,cend,cfirst,i,k) shared(l,partdata)
     for (c=firstCell[l]; c<=lastCell[l]; c++) {
       TreeCell<ndim> &cell = celldata[c];
 
@@ -556,13 +556,46 @@ void Tree<ndim,ParticleType,TreeCell>::ComputeNeighbourList
 //=================================================================================================
 //  Tree::ComputeNeighbourAndGhostList
 /// Computes and returns number of SPH neighbours (Nneib), including lists of ids, from the
-/// tree walk for all active particles inside cell c.
+/// tree walk for all active particles inside cell c.  If a neighbour skin is set, the list of
+/// potential neighbours found by the walk (using the cell boxes inflated by the skin) is cached
+/// and re-used by later calls for the same cell until the particles have moved far enough to
+/// use up the skin (see UpdateNeighbourCache).  The NeighbourManager trims the list to the true
+/// neighbours, so the final neighbour lists are identical in both cases.
 //=================================================================================================
 template <int ndim, template<int> class ParticleType, template<int> class TreeCell>
 void Tree<ndim,ParticleType,TreeCell>::ComputeNeighbourAndGhostList
  (const TreeCellBase<ndim> &cell,      ///< [in] Pointer to cell
   NeighbourManagerBase& neibmanager)
 {
+  const bool use_cache = (neibskin > (FLOAT) 0.0 && cell.id < (int) neibcache.size());
+  Box<ndim> cellbb   = cell.bb;        // (Inflated) bounding box of cell
+  Box<ndim> cellhbox = cell.hbox;      // (Inflated) smoothing-length box of cell
+
+  // If the cell has a valid cached list, add the cached particles and return immediately
+  //-----------------------------------------------------------------------------------------------
+  if (use_cache) {
+    const FLOAT drift = (FLOAT) 2.0*drskin + kernrange*dhskin;
+    if (neibcacheskin[cell.id] >= (FLOAT) 0.0) {
+      if (drift + neibcachedrift[cell.id] <= neibcacheskin[cell.id]) {
+        const vector<int>& cachelist = neibcache[cell.id];
+        for (int j=0; j<(int) cachelist.size(); j++) neibmanager.AddPeriodicNeib(cachelist[j]);
+        return;
+      }
+      neibcacheexpired[cell.id] = 1;
+    }
+
+    // Otherwise inflate the cell boxes by the skin and record the new list below
+    const FLOAT skin = neibskin*kernrange*cell.hmax;
+    for (int k=0; k<ndim; k++) {
+      cellbb.min[k]   -= skin;
+      cellbb.max[k]   += skin;
+      cellhbox.min[k] -= skin;
+      cellhbox.max[k] += skin;
+    }
+    neibcache[cell.id].clear();
+    neibcacheskin[cell.id]  = skin;
+    neibcachedrift[cell.id] = drift;
+  }
 
   // Declare objects/variables required for creating ghost particles
   const GhostNeighbourFinder<ndim> GhostFinder(_domain, cell) ;
@@ -576,8 +609,8 @@ void Tree<ndim,ParticleType,TreeCell>::ComputeNeighbourAndGhostList
 
     // Check if bounding boxes overlap with each other (for potential SPH neibs)
     //---------------------------------------------------------------------------------------------
-    if (GhostFinder.PeriodicBoxOverlap(cell.bb, celldata[cc].hbox) ||
-        GhostFinder.PeriodicBoxOverlap(cell.hbox, celldata[cc].bb)) {
+    if (GhostFinder.PeriodicBoxOverlap(cellbb, celldata[cc].hbox) ||
+        GhostFinder.PeriodicBoxOverlap(cellhbox, celldata[cc].bb)) {
 
       // If not a leaf-cell, then open cell to first child cell
       if (celldata[cc].copen != -1) {
@@ -594,6 +627,7 @@ void Tree<ndim,ParticleType,TreeCell>::ComputeNeighbourAndGhostList
         int i = celldata[cc].ifirst;
         while (i != -1) {
           neibmanager.AddPeriodicNeib(i) ;
+          if (use_cache) neibcache[cell.id].push_back(i);
           if (i == celldata[cc].ilast) break;
           i = inext[i];
         }
@@ -618,6 +652,78 @@ void Tree<ndim,ParticleType,TreeCell>::ComputeNeighbourAndGhostList
 
 
 
+//=================================================================================================
+//  Tree::UpdateNeighbourCache
+/// Update the maximum particle displacement and change in smoothing length since the cached
+/// neighbour lists were reset.  A cached list remains valid while the boxes of the cell and all
+/// overlapping cells have moved (or grown) by less than the skin since it was created.  Since
+/// each list is created at some point after the reset, the total drift is bounded by the drift
+/// at creation plus the current drift.  All lists are discarded, and the reference positions
+/// reset, after a tree re-build or once any cell's list has expired.  Must be called whenever
+/// the positions or smoothing lengths of the particles in the cell boxes are updated.
+//=================================================================================================
+template <int ndim, template<int> class ParticleType, template<int> class TreeCell>
+void Tree<ndim,ParticleType,TreeCell>::UpdateNeighbourCache
+ (const Particle<ndim> *part_gen,      ///< [in] Particle data array
+  const bool rebuild)                  ///< [in] Flag if the tree has been re-built
+{
+  const ParticleType<ndim>* partdata = reinterpret_cast<const ParticleType<ndim>* >(part_gen);
+  bool reset = rebuild;                // Flag to discard all cached lists
+  int c;                               // Cell counter
+  int i;                               // Particle counter
+  int k;                               // Dimension counter
+
+  if (neibskin <= (FLOAT) 0.0) return;
+
+  debug2("[Tree::UpdateNeighbourCache]");
+
+  if ((int) neibcache.size() != Ncell || (int) hskin.size() != Ntot) reset = true;
+  for (c=0; c<(int) neibcacheexpired.size(); c++) {
+    if (neibcacheexpired[c]) reset = true;
+  }
+
+  // Discard all cached lists and record the new reference positions
+  //-----------------------------------------------------------------------------------------------
+  if (reset) {
+    neibcache.resize(Ncell);
+    for (c=0; c<Ncell; c++) neibcache[c].clear();
+    neibcacheskin.assign(Ncell, (FLOAT) -1.0);
+    neibcachedrift.assign(Ncell, (FLOAT) 0.0);
+    neibcacheexpired.assign(Ncell, 0);
+    rskin.resize(ndim*Ntot);
+    hskin.resize(Ntot);
+    for (i=0; i<Ntot; i++) {
+      for (k=0; k<ndim; k++) rskin[ndim*i + k] = partdata[i].r[k];
+      hskin[i] = partdata[i].h;
+    }
+    drskin = (FLOAT) 0.0;
+    dhskin = (FLOAT) 0.0;
+  }
+
+  // Otherwise compute the maximum drift of all particles since the reset
+  //-----------------------------------------------------------------------------------------------
+  else {
+    FLOAT drsqdmax = (FLOAT) 0.0;
+    FLOAT dhmax = (FLOAT) 0.0;
+    for (i=0; i<Ntot; i++) {
+      if (partdata[i].flags.is_dead()) continue;
+      FLOAT drsqd = (FLOAT) 0.0;
+      for (k=0; k<ndim; k++) {
+        const FLOAT dr = partdata[i].r[k] - rskin[ndim*i + k];
+        drsqd += dr*dr;
+      }
+      drsqdmax = max(drsqdmax, drsqd);
+      dhmax = max(dhmax, fabs(partdata[i].h - hskin[i]));
+    }
+    drskin = max(drskin, sqrt(drsqdmax));
+    dhskin = max(dhskin, dhmax);
+  }
+
+  return;
+}
+
+
+
 //=================================================================================================
 //  Tree::ComputeGravityInteractionAndGhostList
 /// Computes and returns number of SPH neighbours (Nneib), direct sum particles (Ndirect) and
@@ -689,6 +795,12 @@ void Tree<ndim,ParticleType,TreeCell>::ComputeGravityInteractionAndGhostList
       cc = celldata[cc].cnext;
     }
 
+    // If using a short-range (TreePM) gravity cut-off, skip cells beyond the cut-off radius
+    //---------------------------------------------------------------------------------------------
+    else if (rcutgrav > 0.0 && drsqd > pow(rcutgrav + rmax + celldata[cc].rmax, 2)) {
+      cc = celldata[cc].cnext;
+    }
+
 
     // Check if cell is far enough away to use the COM approximation
     //---------------------------------------------------------------------------------------------
@@ -736,6 +848,176 @@ void Tree<ndim,ParticleType,TreeCell>::ComputeGravityInteractionAndGhostList
 
 
 
+//=================================================================================================
+//  Tree::ComputeFmmExpansions
+/// Computes the local expansions of the gravitational field of all cells containing active
+/// particles with the dual-tree fast multipole method.  All pairs of cells are walked
+/// simultaneously starting from the root, and pairs which are well-separated according to the
+/// MAC of both cells interact via their multipole moments (M2L), with the geometric terms
+/// evaluated once for both cells.  Otherwise the larger cell is opened, until both cells are
+/// leaf cells, which are then recorded in the near-field lists of each other for the direct
+/// (particle-particle) part of the gravity calculation.  Finally, the expansions are propagated
+/// down the tree (L2L) so that each leaf cell contains the field of all distant cells.
+//=================================================================================================
+template <int ndim, template<int> class ParticleType, template<int> class TreeCell>
+void Tree<ndim,ParticleType,TreeCell>::ComputeFmmExpansions(void)
+{
+  int c;                               // Cell counter
+  FLOAT dr[ndim];                      // Relative position vector
+  FLOAT drp[ndim];                     // Relative position vector of nearest periodic replica
+  const GhostNeighbourFinder<ndim> GhostFinder(_domain);
+  vector<pair<int,int> > pairs;        // Stack of cell pairs still to be walked
+
+  debug2("[Tree::ComputeFmmExpansions]");
+
+  fmmlocal.resize(Ncell);
+  fmmnear.resize(Ncell);
+  fmmactive.resize(Ncell);
+
+  // Flag all cells containing active particles (children are always stored after their parent)
+  // and reset all local expansions to be centred on the cell COM (or centre if massless)
+  //-----------------------------------------------------------------------------------------------
+  for (c=Ncell-1; c>=0; c--) {
+    const TreeCell<ndim> &cell = celldata[c];
+    if (cell.copen == -1) {
+      fmmactive[c] = (cell.Nactive > 0);
+    }
+    else {
+      fmmactive[c] = 0;
+      for (int cc=cell.copen; cc!=cell.cnext; cc=celldata[cc].cnext) {
+        assert(cc > c);
+        if (fmmactive[cc]) fmmactive[c] = 1;
+      }
+    }
+    fmmnear[c].clear();
+    fmmlocal[c].Zero();
+    for (int k=0; k<ndim; k++) fmmlocal[c].rc[k] = (cell.m > 0) ? cell.r[k] : cell.rcell[k];
+  }
+
+
+  // Walk all pairs of cells, starting with the root cell interacting with itself
+  //===============================================================================================
+  pairs.push_back(make_pair(0, 0));
+
+  while (!pairs.empty()) {
+    const int ca = pairs.back().first;
+    const int cb = pairs.back().second;
+    const TreeCell<ndim> &cella = celldata[ca];
+    const TreeCell<ndim> &cellb = celldata[cb];
+    pairs.pop_back();
+
+    if (cella.N == 0 || cellb.N == 0) continue;
+    if (!fmmactive[ca] && !fmmactive[cb]) continue;
+
+    // Cell interacting with itself; either a leaf cell or walk all pairs of its children
+    //---------------------------------------------------------------------------------------------
+    if (ca == cb) {
+      if (cella.copen == -1) {
+        fmmnear[ca].push_back(ca);
+      }
+      else {
+        for (int c1=cella.copen; c1!=cella.cnext; c1=celldata[c1].cnext) {
+          for (int c2=c1; c2!=cella.cnext; c2=celldata[c2].cnext) {
+            pairs.push_back(make_pair(c1, c2));
+          }
+        }
+      }
+      continue;
+    }
+
+    for (int k=0; k<ndim; k++) dr[k] = cellb.rcell[k] - cella.rcell[k];
+    for (int k=0; k<ndim; k++) drp[k] = dr[k];
+    GhostFinder.NearestPeriodicVector(drp);
+    const FLOAT drsqd  = DotProduct(dr, dr, ndim);
+    const FLOAT drpsqd = DotProduct(drp, drp, ndim);
+
+    // If the cells are well-separated, add the multipole terms to both local expansions
+    //---------------------------------------------------------------------------------------------
+    if (fmm_well_separated(cella, cellb, drsqd, drpsqd)) {
+      FmmLocalExpansion<ndim> *locala = fmmactive[ca] ? &(fmmlocal[ca]) : NULL;
+      FmmLocalExpansion<ndim> *localb = fmmactive[cb] ? &(fmmlocal[cb]) : NULL;
+      if (cella.m > 0 && cellb.m > 0) {
+        for (int k=0; k<ndim; k++) dr[k] = cellb.r[k] - cella.r[k];
+        AddFmmInteraction(dr, cella, locala, cellb, localb);
+      }
+      else if (cellb.m > 0 && locala != NULL) {
+        for (int k=0; k<ndim; k++) dr[k] = cellb.r[k] - locala->rc[k];
+        AddFmmInteraction(dr, cella, locala, cellb, (FmmLocalExpansion<ndim> *) NULL);
+      }
+      else if (cella.m > 0 && localb != NULL) {
+        for (int k=0; k<ndim; k++) dr[k] = cella.r[k] - localb->rc[k];
+        AddFmmInteraction(dr, cellb, localb, cella, (FmmLocalExpansion<ndim> *) NULL);
+      }
+    }
+
+    // If both are leaf cells, record each in the near-field list of the other
+    //---------------------------------------------------------------------------------------------
+    else if (cella.copen == -1 && cellb.copen == -1) {
+      if (fmmactive[ca]) fmmnear[ca].push_back(cb);
+      if (fmmactive[cb]) fmmnear[cb].push_back(ca);
+    }
+
+    // Otherwise open the larger of the two cells
+    //---------------------------------------------------------------------------------------------
+    else if (cellb.copen == -1 || (cella.copen != -1 && cella.rmax >= cellb.rmax)) {
+      for (int cc=cella.copen; cc!=cella.cnext; cc=celldata[cc].cnext) {
+        pairs.push_back(make_pair(cc, cb));
+      }
+    }
+    else {
+      for (int cc=cellb.copen; cc!=cellb.cnext; cc=celldata[cc].cnext) {
+        pairs.push_back(make_pair(ca, cc));
+      }
+    }
+
+  }
+  //===============================================================================================
+
+
+  // Propagate the local expansions down the tree to all active child cells
+  //-----------------------------------------------------------------------------------------------
+  for (c=0; c<Ncell; c++) {
+    if (celldata[c].copen == -1 || !fmmactive[c]) continue;
+    for (int cc=celldata[c].copen; cc!=celldata[c].cnext; cc=celldata[cc].cnext) {
+      if (fmmactive[cc]) fmmlocal[c].ShiftTo(fmmlocal[cc]);
+    }
+  }
+
+  return;
+}
+
+
+
+//=================================================================================================
+//  Tree::ComputeFmmNearList
+/// Adds all particles in the near-field cells of the (active leaf) cell found by the dual-tree
+/// walk in ComputeFmmExpansions to the neighbour manager, as potential hydro neighbours or
+/// direct-sum gravity particles.  Replaces ComputeGravityInteractionAndGhostList for the fmm
+/// multipole option, since the field of all other cells is contained in the local expansion.
+//=================================================================================================
+template <int ndim, template<int> class ParticleType, template<int> class TreeCell>
+void Tree<ndim,ParticleType,TreeCell>::ComputeFmmNearList
+ (const TreeCellBase<ndim> &cell,      ///< [in] Pointer to cell
+  NeighbourManagerDim<ndim>& neibmanager)   ///< [inout] Neighbour manager object
+{
+  assert(cell.id < (int) fmmnear.size());
+  const vector<int> &nearlist = fmmnear[cell.id];
+
+  for (int jj=0; jj<(int) nearlist.size(); jj++) {
+    const int cc = nearlist[jj];
+    int i = celldata[cc].ifirst;
+    while (i != -1) {
+      neibmanager.AddPeriodicNeib(i);
+      if (i == celldata[cc].ilast) break;
+      i = inext[i];
+    };
+  }
+
+  return;
+}
+
+
+
 //=================================================================================================
 //  Tree::ComputeStarGravityInteractionList
 /// Computes and returns number of SPH neighbours (Nneib), direct sum particles (Ndirect) and
@@ -764,6 +1046,7 @@ int Tree<ndim,ParticleType,TreeCell>::ComputeStarGravityInteractionList
   int i;                               // Particle id
   int k;                               // Neighbour counter
   FLOAT dr[ndim];                      // Relative position vector
+  FLOAT dr_corr[ndim];                 // Periodic correction vector
   FLOAT drsqd;                         // Distance squared
   FLOAT hrangemax;                     // Maximum kernel extent
   FLOAT rs[ndim];                      // Position of star
@@ -787,6 +1070,7 @@ int Tree<ndim,ParticleType,TreeCell>::ComputeStarGravityInteractionList
   while (cc < Ncell) {
 
     for (k=0; k<ndim; k++) dr[k] = celldata[cc].rcell[k] - rs[k];
+    if (_domain.PeriodicGravity) NearestPeriodicVector(_domain, dr, dr_corr);
     drsqd = DotProduct(dr, dr, ndim);
 
 
@@ -818,6 +1102,12 @@ int Tree<ndim,ParticleType,TreeCell>::ComputeStarGravityInteractionList
 
     }
 
+    // If using a short-range (TreePM) gravity cut-off, skip cells beyond the cut-off radius
+    //---------------------------------------------------------------------------------------------
+    else if (rcutgrav > 0.0 && drsqd > pow(rcutgrav + celldata[cc].rmax, 2)) {
+      cc = celldata[cc].cnext;
+    }
+
     // Check if cell is far enough away to use the COM approximation
     //---------------------------------------------------------------------------------------------
     else if (drsqd > celldata[cc].cdistsqd && celldata[cc].N > 0) {